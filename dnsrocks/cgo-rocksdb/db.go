@@ -24,6 +24,7 @@ import "C"
 
 import (
 	"errors"
+	"sync"
 	"unsafe"
 )
 
@@ -34,6 +35,9 @@ type RocksDB struct {
 	secondary     bool
 	secondaryPath string
 	options       *Options
+
+	cDefaultCF     *C.rocksdb_column_family_handle_t
+	cDefaultCFOnce sync.Once
 }
 
 // OpenDatabase opens the database directory with provided options,
@@ -366,8 +370,21 @@ func (db *RocksDB) GetOptions() *Options {
 	return db.options
 }
 
+// defaultColumnFamily lazily resolves the handle of the default column family;
+// it is required by the batched (pinnable) multi-get API
+func (db *RocksDB) defaultColumnFamily() *C.rocksdb_column_family_handle_t {
+	db.cDefaultCFOnce.Do(func() {
+		db.cDefaultCF = C.rocksdb_get_default_column_family_handle(db.cDB)
+	})
+	return db.cDefaultCF
+}
+
 // CloseDatabase frees the memory and closes the connection
 func (db *RocksDB) CloseDatabase() {
+	if db.cDefaultCF != nil {
+		C.rocksdb_column_family_handle_destroy(db.cDefaultCF)
+		db.cDefaultCF = nil
+	}
 	db.options.FreeOptions()
 	C.rocksdb_close(db.cDB)
 }
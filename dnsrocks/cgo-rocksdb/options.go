@@ -210,6 +210,14 @@ func (options *Options) SetPrefixExtractorSize(prefixSize int) {
 	C.rocksdb_options_set_prefix_extractor(options.cOptions, p)
 }
 
+// SetMemtablePrefixBloomSizeRatio sizes the memtable prefix bloom filter as
+// a fraction of write_buffer_size; 0 disables it. Only effective when a
+// prefix extractor is set.
+// https://github.com/facebook/rocksdb/wiki/Prefix-Seek
+func (options *Options) SetMemtablePrefixBloomSizeRatio(ratio float64) {
+	C.rocksdb_options_set_memtable_prefix_bloom_size_ratio(options.cOptions, C.double(ratio))
+}
+
 // some compaction options
 
 // SetNumLevels sets number of compaction levels when level-based compaction is used.
@@ -476,6 +484,22 @@ func (readOptions *ReadOptions) UnsetSnapshot() {
 	C.rocksdb_readoptions_set_snapshot(readOptions.cReadOptions, nil)
 }
 
+// SetTotalOrderSeek sets total_order_seek flag, which keeps iterators in
+// total order mode even when the database has a prefix extractor
+// https://github.com/facebook/rocksdb/wiki/Prefix-Seek
+func (readOptions *ReadOptions) SetTotalOrderSeek(totalOrderSeek bool) {
+	C.rocksdb_readoptions_set_total_order_seek(readOptions.cReadOptions, BoolToChar(totalOrderSeek))
+}
+
+// SetPrefixSameAsStart sets prefix_same_as_start flag, making an iterator
+// stop once it leaves the prefix of the seek key; with a prefix extractor
+// such iterators can skip memtables and SST files through prefix bloom
+// filters
+// https://github.com/facebook/rocksdb/wiki/Prefix-Seek
+func (readOptions *ReadOptions) SetPrefixSameAsStart(prefixSameAsStart bool) {
+	C.rocksdb_readoptions_set_prefix_same_as_start(readOptions.cReadOptions, BoolToChar(prefixSameAsStart))
+}
+
 // SetIterateLowerBound sets lower bound for key seek
 // https://github.com/facebook/rocksdb/wiki/Iterator
 func (readOptions *ReadOptions) SetIterateLowerBound(key []byte) {
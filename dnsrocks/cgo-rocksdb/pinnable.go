@@ -0,0 +1,136 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package rocksdb
+
+/*
+// @fb-only: #include "rocksdb/src/include/rocksdb/c.h"
+#cgo pkg-config: "rocksdb"
+#include "rocksdb/c.h" // @oss-only
+
+#include <stdbool.h>
+#include <stdlib.h> // for free()
+*/
+import "C"
+
+import (
+	"errors"
+	"unsafe"
+)
+
+// PinnableSlice is a read-only view of a value owned by RocksDB
+// (block cache or memtable memory). It avoids copying the value across
+// the cgo boundary on every Get; the memory stays valid and pinned until
+// Destroy is called.
+type PinnableSlice struct {
+	cSlice *C.rocksdb_pinnableslice_t
+	data   []byte
+}
+
+// Data returns the pinned value bytes. The slice aliases RocksDB-owned
+// memory: it must not be modified and must not be used after Destroy.
+func (s *PinnableSlice) Data() []byte {
+	return s.data
+}
+
+// Destroy releases the pin so RocksDB can reclaim the underlying memory.
+// It is safe to call on a nil receiver and safe to call more than once.
+func (s *PinnableSlice) Destroy() {
+	if s == nil || s.cSlice == nil {
+		return
+	}
+	C.rocksdb_pinnableslice_destroy(s.cSlice)
+	s.cSlice = nil
+	s.data = nil
+}
+
+// PinBytes wraps a Go-owned buffer in a PinnableSlice; Destroy is a no-op.
+// It lets code paths (and mocks) that produce plain byte slices satisfy
+// pinned-value APIs.
+func PinBytes(data []byte) *PinnableSlice {
+	return &PinnableSlice{data: data}
+}
+
+// GetPinned retrieves the value associated with the byte key without
+// copying it out of RocksDB. Returns nil if the key is not found.
+// The caller must call Destroy on the returned slice when done with the value.
+func (db *RocksDB) GetPinned(readOptions *ReadOptions, key []byte) (*PinnableSlice, error) {
+	var cError *C.char
+	cKeyPtr, cKeyLen := bytesToPtr(key)
+	cSlice := C.rocksdb_get_pinned(
+		db.cDB, readOptions.cReadOptions,
+		cKeyPtr, cKeyLen,
+		&cError,
+	)
+	if cError != nil {
+		err := errors.New(C.GoString(cError))
+		C.rocksdb_free(unsafe.Pointer(cError))
+		return nil, err
+	}
+	if cSlice == nil {
+		return nil, nil
+	}
+	return newPinnableSlice(cSlice), nil
+}
+
+// GetMultiPinned retrieves multiple values associated with multiple byte keys
+// without copying them out of RocksDB; returns two arrays of corresponding
+// size - one with pinned slices (nil for missing keys), and another with
+// errors (or nil's). The caller must call Destroy on every non-nil slice.
+func (db *RocksDB) GetMultiPinned(readOptions *ReadOptions, keys [][]byte) ([]*PinnableSlice, []error) {
+	keysCount := len(keys)
+
+	cSlices := make([]*C.rocksdb_pinnableslice_t, keysCount)
+	scErrors := make(charsSlice, keysCount)
+
+	keyList := bytesListToPtrList(keys)
+	C.rocksdb_batched_multi_get_cf(
+		db.cDB, readOptions.cReadOptions,
+		db.defaultColumnFamily(),
+		C.size_t(keysCount), keyList.cChars.c(), keyList.cLengths.c(),
+		unsafe.SliceData(cSlices), scErrors.c(), C.bool(false),
+	)
+	keyList.freePtrList()
+
+	errorList := make([]error, keysCount)
+	for i := 0; i < len(scErrors); i++ {
+		if scErrors[i] != nil {
+			errorList[i] = errors.New(C.GoString(scErrors[i]))
+			C.rocksdb_free(unsafe.Pointer(scErrors[i]))
+		}
+	}
+
+	valueList := make([]*PinnableSlice, keysCount)
+	for i, cSlice := range cSlices {
+		if cSlice == nil {
+			continue
+		}
+		valueList[i] = newPinnableSlice(cSlice)
+	}
+
+	return valueList, errorList
+}
+
+// newPinnableSlice wraps the C pinnable slice, materializing the value view
+func newPinnableSlice(cSlice *C.rocksdb_pinnableslice_t) *PinnableSlice {
+	var cValueLen C.size_t
+	cValue := C.rocksdb_pinnableslice_value(cSlice, &cValueLen)
+	if cValue == nil {
+		C.rocksdb_pinnableslice_destroy(cSlice)
+		return nil
+	}
+	return &PinnableSlice{
+		cSlice: cSlice,
+		data:   unsafe.Slice((*byte)(unsafe.Pointer(cValue)), int(cValueLen)),
+	}
+}
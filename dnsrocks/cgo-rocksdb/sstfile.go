@@ -31,6 +31,7 @@ type SSTFileWriter struct {
 	cFileWriter *C.rocksdb_sstfilewriter_t
 	cEnvOptions *C.rocksdb_envoptions_t
 	dbOptions   *Options
+	ownsOptions bool
 }
 
 // CreateSSTFileWriter creates SSTFileWriter object using provided file path
@@ -38,6 +39,21 @@ func CreateSSTFileWriter(path string) (*SSTFileWriter, error) {
 	options := NewOptions()
 	options.EnableCreateIfMissing()
 
+	writer, err := CreateSSTFileWriterWithOptions(path, options)
+	if err != nil {
+		options.FreeOptions()
+		return nil, err
+	}
+	writer.ownsOptions = true
+	return writer, nil
+}
+
+// CreateSSTFileWriterWithOptions creates SSTFileWriter using the provided
+// options, so the written file carries the same table format - bloom filter,
+// compression and block settings - as the database it will be ingested into.
+// The caller keeps ownership of options and must free them only after
+// CloseWriter.
+func CreateSSTFileWriterWithOptions(path string, options *Options) (*SSTFileWriter, error) {
 	sstPath := C.CString(path)
 	defer C.free(unsafe.Pointer(sstPath))
 
@@ -49,6 +65,8 @@ func CreateSSTFileWriter(path string) (*SSTFileWriter, error) {
 
 	if cError != nil {
 		defer C.rocksdb_free(unsafe.Pointer(cError))
+		C.rocksdb_sstfilewriter_destroy(fileWriter)
+		C.rocksdb_envoptions_destroy(envOptions)
 		return nil, errors.New(C.GoString(cError))
 	}
 	return &SSTFileWriter{
@@ -96,6 +114,8 @@ func (w *SSTFileWriter) GetFileSize() uint64 {
 // CloseWriter frees memory structures associated with the object
 func (w *SSTFileWriter) CloseWriter() {
 	C.rocksdb_sstfilewriter_destroy(w.cFileWriter)
-	w.dbOptions.FreeOptions()
+	if w.ownsOptions {
+		w.dbOptions.FreeOptions()
+	}
 	C.rocksdb_envoptions_destroy(w.cEnvOptions)
 }
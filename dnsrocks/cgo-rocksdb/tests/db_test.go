@@ -413,6 +413,64 @@ func TestByteValue(t *testing.T) {
 	}
 }
 
+// TestPinnedValue tests GetPinned/GetMultiPinned zero-copy reads
+func TestPinnedValue(t *testing.T) {
+	bKey, bValue := []byte("pinned_key"), []byte("pinned_val")
+
+	if err := db.Put(writeOptions, bKey, bValue); err != nil {
+		t.Errorf("Error writing bytes: %s", err.Error())
+	}
+
+	// GetPinned
+	slice, err := db.GetPinned(readOptions, bKey)
+	if err != nil {
+		t.Errorf("Error reading pinned bytes: %s", err.Error())
+	} else if slice == nil {
+		t.Error("GetPinned returned nil for existing key")
+	} else {
+		if !bytes.Equal(slice.Data(), bValue) {
+			t.Errorf("Byte mismatch: %v / %v", slice.Data(), bValue)
+		}
+		slice.Destroy()
+		// double Destroy must be safe
+		slice.Destroy()
+	}
+
+	// GetPinned for nonexistent key returns nil slice
+	if slice, err := db.GetPinned(readOptions, []byte("NON_EXISTENT_KEY")); err != nil {
+		t.Errorf("Error reading nonexistent pinned bytes: %s", err.Error())
+	} else if slice != nil {
+		t.Errorf("Expected nil slice, got %v", slice.Data())
+		slice.Destroy()
+	}
+
+	// GetMultiPinned over existing and nonexistent keys
+	requestKeys := [][]byte{bKey, []byte("NON_EXISTENT_KEY"), bKey}
+	slices, errors := db.GetMultiPinned(readOptions, requestKeys)
+	for i, err := range errors {
+		if err != nil {
+			t.Errorf("Error reading key %v: %s", requestKeys[i], err.Error())
+		}
+	}
+	for _, i := range []int{0, 2} {
+		if slices[i] == nil {
+			t.Errorf("GetMultiPinned returned nil for existing key %v", requestKeys[i])
+		} else if !bytes.Equal(slices[i].Data(), bValue) {
+			t.Errorf("Byte mismatch: %v / %v", slices[i].Data(), bValue)
+		}
+	}
+	if slices[1] != nil {
+		t.Errorf("Expected nil slice, got %v", slices[1].Data())
+	}
+	for _, slice := range slices {
+		slice.Destroy()
+	}
+
+	if err := db.Delete(writeOptions, bKey); err != nil {
+		t.Errorf("Error deleting bytes: %s", err.Error())
+	}
+}
+
 // TestBatch tests creating, writing and deleting a batch
 func TestBatch(t *testing.T) {
 	batch := db.NewBatch()
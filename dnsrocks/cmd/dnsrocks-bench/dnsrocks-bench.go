@@ -0,0 +1,210 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// dnsrocks-bench replays a query log through the full handler stack against
+// a local database and reports throughput, allocation rates and latency
+// percentiles per query type. It exercises the same path as production
+// queries (FBDNSDB.ServeDNSWithRCODE via QuerySingle), so handler or storage
+// regressions show up before they reach production.
+//
+// The query log is text, one query per line:
+//
+//	qname qtype [resolver-ip] [client-subnet]
+//
+// with '#' starting a comment. A log can be replayed several times with
+// -repeat to get stable numbers out of small fixtures.
+package main
+
+import (
+	"bufio"
+	"flag"
+	"fmt"
+	"log"
+	"os"
+	"runtime"
+	"sort"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/facebook/dns/dnsrocks/dnsserver"
+	"github.com/facebook/dns/dnsrocks/dnsserver/stats"
+)
+
+// benchQuery is one parsed query log line
+type benchQuery struct {
+	qname    string
+	qtype    string
+	resolver string
+	subnet   string
+}
+
+// benchResult collects per-qtype latencies from one worker
+type benchResult struct {
+	latencies map[string][]time.Duration
+	failures  int
+}
+
+func parseQueryLog(path string, defaultResolver string) ([]benchQuery, error) {
+	file, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer file.Close()
+
+	var queries []benchQuery
+	scanner := bufio.NewScanner(file)
+	for scanner.Scan() {
+		line := strings.TrimSpace(scanner.Text())
+		if line == "" || strings.HasPrefix(line, "#") {
+			continue
+		}
+		fields := strings.Fields(line)
+		if len(fields) < 2 {
+			return nil, fmt.Errorf("malformed query log line %q, want 'qname qtype [resolver] [subnet]'", line)
+		}
+		q := benchQuery{qname: fields[0], qtype: fields[1], resolver: defaultResolver}
+		if len(fields) > 2 {
+			q.resolver = fields[2]
+		}
+		if len(fields) > 3 {
+			q.subnet = fields[3]
+		}
+		queries = append(queries, q)
+	}
+	return queries, scanner.Err()
+}
+
+// replay runs the workers over the query set and merges their results
+func replay(tdb *dnsserver.FBDNSDB, queries []benchQuery, workers, repeat, maxans int) (benchResult, time.Duration) {
+	results := make([]benchResult, workers)
+	var wg sync.WaitGroup
+	start := time.Now()
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func(w int) {
+			defer wg.Done()
+			res := benchResult{latencies: make(map[string][]time.Duration)}
+			for r := 0; r < repeat; r++ {
+				// workers stride over the log so they do not all hit
+				// the same key at the same time
+				for i := w; i < len(queries); i += workers {
+					q := queries[i]
+					qStart := time.Now()
+					rec, err := tdb.QuerySingle(q.qtype, q.qname, q.resolver, q.subnet, maxans)
+					elapsed := time.Since(qStart)
+					if err != nil || rec == nil {
+						res.failures++
+						continue
+					}
+					res.latencies[q.qtype] = append(res.latencies[q.qtype], elapsed)
+				}
+			}
+			results[w] = res
+		}(w)
+	}
+	wg.Wait()
+	elapsed := time.Since(start)
+
+	merged := benchResult{latencies: make(map[string][]time.Duration)}
+	for _, res := range results {
+		merged.failures += res.failures
+		for qtype, lats := range res.latencies {
+			merged.latencies[qtype] = append(merged.latencies[qtype], lats...)
+		}
+	}
+	return merged, elapsed
+}
+
+// percentile returns the p-th percentile of sorted latencies
+func percentile(sorted []time.Duration, p float64) time.Duration {
+	if len(sorted) == 0 {
+		return 0
+	}
+	i := int(p * float64(len(sorted)-1))
+	return sorted[i]
+}
+
+func main() {
+	var (
+		err           error
+		tdb           *dnsserver.FBDNSDB
+		cacheConfig   dnsserver.CacheConfig
+		dbConfig      dnsserver.DBConfig
+		handlerConfig dnsserver.HandlerConfig
+	)
+	flag.StringVar(&dbConfig.Path, "dbpath", "", "Path to the database")
+	flag.StringVar(&dbConfig.Driver, "dbdriver", "rocksdb", "DB driver (cdb or rocksdb)")
+	querylog := flag.String("querylog", "", "Path to the query log to replay")
+	workers := flag.Int("workers", runtime.NumCPU(), "Number of concurrent query workers")
+	repeat := flag.Int("repeat", 1, "Number of times to replay the query log")
+	maxans := flag.Int("maxans", 1, "Max number of answers the server should return")
+	resolver := flag.String("resolver", "127.0.0.1", "Default resolver IP for log lines without one")
+	cacheEnabled := flag.Bool("cache", false, "Enable the answer cache, as in production")
+	flag.Parse()
+
+	if *querylog == "" {
+		log.Fatal("-querylog is required")
+	}
+	queries, err := parseQueryLog(*querylog, *resolver)
+	if err != nil {
+		log.Fatalf("Failed to parse query log: %s", err)
+	}
+	if len(queries) == 0 {
+		log.Fatal("Query log contains no queries")
+	}
+	cacheConfig.Enabled = *cacheEnabled
+
+	if tdb, err = dnsserver.NewFBDNSDB(handlerConfig, dbConfig, cacheConfig, &dnsserver.DummyLogger{}, &stats.DummyStats{}); err != nil {
+		log.Fatalf("Failed to instantiate DB: %s", err)
+	}
+	if err = tdb.Load(); err != nil {
+		log.Fatalf("Failed to load DB: %s %s", dbConfig.Path, err)
+	}
+
+	var before, after runtime.MemStats
+	runtime.GC()
+	runtime.ReadMemStats(&before)
+	merged, elapsed := replay(tdb, queries, *workers, *repeat, *maxans)
+	runtime.ReadMemStats(&after)
+
+	total := 0
+	for _, lats := range merged.latencies {
+		total += len(lats)
+	}
+	if total == 0 {
+		log.Fatalf("All %d queries failed", merged.failures)
+	}
+
+	fmt.Printf("queries: %d  failures: %d  workers: %d  elapsed: %v\n",
+		total, merged.failures, *workers, elapsed.Round(time.Millisecond))
+	fmt.Printf("throughput: %.0f qps\n", float64(total)/elapsed.Seconds())
+	fmt.Printf("allocations: %.1f allocs/query, %.0f B/query\n",
+		float64(after.Mallocs-before.Mallocs)/float64(total),
+		float64(after.TotalAlloc-before.TotalAlloc)/float64(total))
+
+	qtypes := make([]string, 0, len(merged.latencies))
+	for qtype := range merged.latencies {
+		qtypes = append(qtypes, qtype)
+	}
+	sort.Strings(qtypes)
+	fmt.Printf("%-8s %8s %12s %12s %12s %12s\n", "qtype", "count", "p50", "p90", "p99", "p999")
+	for _, qtype := range qtypes {
+		lats := merged.latencies[qtype]
+		sort.Slice(lats, func(i, j int) bool { return lats[i] < lats[j] })
+		fmt.Printf("%-8s %8d %12v %12v %12v %12v\n",
+			qtype, len(lats),
+			percentile(lats, 0.50), percentile(lats, 0.90),
+			percentile(lats, 0.99), percentile(lats, 0.999))
+	}
+}
@@ -29,7 +29,7 @@ func main() {
 	opath := flag.String("o", "data.cdb", "Output path to write the dns DB")
 	cpuprofile := flag.String("cpuprofile", "", "write cpu profile to `file`")
 	memprofile := flag.String("memprofile", "", "write memory profile to `file`")
-	numCPU := flag.Int("numcpu", 1, "number of CPUs to use for parsing in parallel, 0 means all")
+	numCPU := flag.Int("numcpu", 1, "number of CPUs to use for parsing and hash table construction in parallel, 0 means all")
 	flag.Parse()
 
 	if *cpuprofile != "" {
@@ -165,7 +165,7 @@ func (r *DataReader) IsAuthoritative(q []byte, loc *Location) (ns bool, auth boo
 // FindAnswer will find answers for a given query q
 func (r *DataReader) FindAnswer(q []byte, packedControlName []byte, qname string, qtype uint16, loc *Location, a *dns.Msg, maxAnswer int) (bool, bool) {
 	var (
-		wrs         = Wrs{MaxAnswers: maxAnswer}
+		wrs         = GetWrs(maxAnswer)
 		err         error
 		recordFound = false
 		wildcard    = false
@@ -175,6 +175,7 @@ func (r *DataReader) FindAnswer(q []byte, packedControlName []byte, qname string
 		rr  dns.RR
 		rrs []dns.RR
 	)
+	defer PutWrs(wrs)
 
 	parseResult := func(result []byte) error {
 		if errors.Is(err, io.EOF) {
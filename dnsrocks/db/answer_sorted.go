@@ -131,6 +131,13 @@ func (r *sortedDataReader) FindAnswer(q []byte, packedControlName []byte, qname
 }
 
 func (r *sortedDataReader) IsAuthoritative(q []byte, loc *Location) (ns bool, auth bool, zoneCut []byte, err error) {
+	// Longest-suffix match against the in-memory zone cuts when the backend
+	// maintains them; only the answer lookup will touch the storage then.
+	if r.zoneCuts != nil {
+		ns, auth, zoneCut = r.zoneCuts.IsAuthoritative(q, loc)
+		return ns, auth, zoneCut, nil
+	}
+
 	parseResult := func(result []byte) error {
 		rec, err := ExtractRRFromRow(result, false)
 		if err != nil {
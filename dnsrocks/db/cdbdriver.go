@@ -17,6 +17,7 @@ import (
 	"errors"
 	"io"
 	"net"
+	"os"
 	"sync"
 	"time"
 
@@ -24,6 +25,17 @@ import (
 	"github.com/repustate/go-cdb" // local changes include the use of Spooky Hash v1 instead of hash.Hash32
 )
 
+const (
+	// cdbHugepageEnvVar, when set to a non-empty value, makes the CDB
+	// mapping eligible for transparent huge pages (Linux only).
+	cdbHugepageEnvVar = "FBDNS_CDB_MADV_HUGEPAGE"
+	// cdbWarmupEnvVar, when set to a non-empty value, walks the whole
+	// database at open time so the first queries after a reload run at
+	// memory speed instead of faulting in cold pages. Do not enable it if
+	// the CDB file is bigger than the available physical memory.
+	cdbWarmupEnvVar = "FBDNS_CDB_WARMUP"
+)
+
 // implement db.DBI interface with repustate/go-cdb
 type cdbdriver struct {
 	db          *cdb.Cdb
@@ -39,6 +51,19 @@ func openCDB(name string) (DBI, error) {
 	if err != nil {
 		return nil, err
 	}
+	// The database is mmapped: start the hash tables reading in right away,
+	// they are the first thing every lookup touches.
+	c.PrefetchIndex()
+	if os.Getenv(cdbHugepageEnvVar) != "" {
+		c.AdviseHugepage()
+	}
+	if os.Getenv(cdbWarmupEnvVar) != "" {
+		// Synchronous on purpose: Reload opens the new database before
+		// swapping it in, so the old one keeps serving while this walks.
+		start := time.Now()
+		c.Warmup()
+		glog.Infof("Finished CDB warmup walk of %s in %v", name, time.Since(start))
+	}
 	driver := &cdbdriver{c, sync.Pool{New: newCdbContextFunc}}
 	return driver, nil
 }
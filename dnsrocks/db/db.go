@@ -19,6 +19,7 @@ import (
 	"fmt"
 	"net"
 	"sync"
+	"sync/atomic"
 	"time"
 
 	"github.com/facebook/dns/dnsrocks/dnsdata"
@@ -51,6 +52,13 @@ type ClosestKeyFinder interface {
 	FindClosestKey(key []byte, context Context) ([]byte, error)
 }
 
+// KeyPrefetcher is implemented by DBI backends which can resolve a set of
+// keys in one batched read, priming the query context so the per-key
+// Find/ForEach calls that follow are served from it
+type KeyPrefetcher interface {
+	PrefetchKeys(keys [][]byte, context Context) error
+}
+
 // Context interface is an ADT representing the state carried across queries to DBI
 // like iterator state or potentially query cache
 type Context interface {
@@ -59,10 +67,28 @@ type Context interface {
 
 // DB implements a customized db
 type DB struct {
-	dbi         DBI
-	destroyable bool
-	refCount    uint64
-	l           sync.RWMutex
+	dbi DBI
+	// refCount counts one reference held by the owner (dropped in Destroy)
+	// plus one per open reader, so acquiring and releasing a reader is a
+	// single atomic op instead of a mutex shared by every query. Whoever
+	// drops the count to zero closes the underlying database.
+	refCount atomic.Int64
+}
+
+// newDB wraps a DBI, taking the owner's reference
+func newDB(dbi DBI) *DB {
+	db := &DB{dbi: dbi}
+	db.refCount.Store(1)
+	return db
+}
+
+// release drops one reference and closes the underlying database when it was
+// the last one
+func (f *DB) release() {
+	if f.refCount.Add(-1) == 0 {
+		glog.Infof("refcount == 0: Closing DB")
+		f.dbi.Close()
+	}
 }
 
 // Reader will be able to perform DNS queries.
@@ -92,6 +118,15 @@ type DataReader struct {
 type sortedDataReader struct {
 	DataReader
 	closestKeyFinder ClosestKeyFinder
+	// zoneCuts serves authority determination from RAM when the backend
+	// provides a zone-cut index; nil falls back to storage probes
+	zoneCuts *zoneCutIndex
+}
+
+// zoneCutProvider is implemented by DBI backends which maintain an in-memory
+// index of the zone cuts
+type zoneCutProvider interface {
+	ZoneCuts() *zoneCutIndex
 }
 
 // ErrValidationKeyNotFound - Key not found in DB file
@@ -117,7 +152,7 @@ func Open(name string, driver string) (*DB, error) {
 	if err != nil {
 		return nil, err
 	}
-	return &DB{dbi: dbi}, nil
+	return newDB(dbi), nil
 }
 
 // NewReader returns a new DB reader to be used to perform DNS record search in DB.
@@ -125,9 +160,7 @@ func NewReader(db *DB) (Reader, error) {
 	if db == nil {
 		return &DataReader{}, fmt.Errorf("Cannot create new reader, DB is not initialized")
 	}
-	db.l.Lock()
-	defer db.l.Unlock()
-	db.refCount++
+	db.refCount.Add(1)
 	context := db.dbi.NewContext()
 
 	reader := DataReader{db: db, context: context}
@@ -135,23 +168,21 @@ func NewReader(db *DB) (Reader, error) {
 	closestKeyFinder := db.dbi.ClosestKeyFinder()
 
 	if closestKeyFinder != nil {
-		return &sortedDataReader{DataReader: reader, closestKeyFinder: closestKeyFinder}, nil
+		sorted := &sortedDataReader{DataReader: reader, closestKeyFinder: closestKeyFinder}
+		if provider, ok := db.dbi.(zoneCutProvider); ok {
+			sorted.zoneCuts = provider.ZoneCuts()
+		}
+		return sorted, nil
 	}
 
 	return &reader, nil
 }
 
-// Destroy destroys a DB. It marks it as destroyable. If there is no refCount
-// it will close the db, if there is refcounts left, the last reference to
+// Destroy destroys a DB by dropping the owner's reference. If there are no
+// readers left it closes the db immediately, otherwise the last reader to
 // call Reader.Close() will close the db.
 func (f *DB) Destroy() {
-	f.l.Lock()
-	defer f.l.Unlock()
-	f.destroyable = true
-	if f.refCount == 0 {
-		glog.Infof("refcount == 0: Closing DB")
-		f.dbi.Close()
-	}
+	f.release()
 }
 
 // Reload reloads a DB. In case of immutable CDB it will return new DB and close the old one.
@@ -205,8 +236,8 @@ func (f *DB) Reload(path string, validationKey []byte, reloadTimeout time.Durati
 		}
 
 		// Validate newDBI
-		newDB := &DB{dbi: newDBI}
-		err = newDB.validateDbKeyOrDestroy(validationKey)
+		candidate := newDB(newDBI)
+		err = candidate.validateDbKeyOrDestroy(validationKey)
 		if err != nil {
 			glog.Errorf("Key validation for New DBI failed, using old DB instead")
 			return f, err
@@ -216,7 +247,7 @@ func (f *DB) Reload(path string, validationKey []byte, reloadTimeout time.Durati
 			glog.Infof("New DBI, old one will be destroyed")
 			// we have to deal with it here in this fashion because we handle refcounter on this level
 			f.Destroy()
-			return newDB, nil
+			return candidate, nil
 		}
 	}
 
@@ -294,21 +325,18 @@ func (r *DataReader) ForEach(key []byte, f func(value []byte) error) (err error)
 // Close close a reader. This puts back a context in the pool
 func (r *DataReader) Close() {
 	r.db.dbi.FreeContext(r.context)
-	r.db.l.Lock()
-	defer r.db.l.Unlock()
-	r.db.refCount--
-	if r.db.destroyable && r.db.refCount == 0 {
-		glog.Infof("refcount == 0 && destroyable: Closing DB")
-		r.db.dbi.Close()
-	}
+	r.db.release()
 }
 
 // ForEachResourceRecord calls parseRecord for each RR record in DB in provided AND default location
 func (r *DataReader) ForEachResourceRecord(domainName []byte, loc *Location, parseRecord func(result []byte) error) error {
 	var err error
 
+	nonLocalPackedName := append(EmptyLocation.LocID[:], domainName...)
+
 	if !loc.IsEmpty() {
 		localPackedName := append(loc.LocID[:], domainName...)
+		r.prefetchKeys(localPackedName, nonLocalPackedName)
 		err = r.ForEach(localPackedName, parseRecord)
 		if err != nil {
 			glog.Errorf("Error %v", err)
@@ -316,7 +344,6 @@ func (r *DataReader) ForEachResourceRecord(domainName []byte, loc *Location, par
 		}
 	}
 
-	nonLocalPackedName := append(EmptyLocation.LocID[:], domainName...)
 	err = r.ForEach(nonLocalPackedName, parseRecord)
 	if err != nil {
 		glog.Errorf("Error %v", err)
@@ -326,6 +353,19 @@ func (r *DataReader) ForEachResourceRecord(domainName []byte, loc *Location, par
 	return nil
 }
 
+// prefetchKeys resolves the keys a request is about to look up in one
+// batched read when the backing driver supports it. Failures are not fatal:
+// the per-key lookups that follow will surface any persistent DB error.
+func (r *DataReader) prefetchKeys(keys ...[]byte) {
+	prefetcher, ok := r.db.dbi.(KeyPrefetcher)
+	if !ok {
+		return
+	}
+	if err := prefetcher.PrefetchKeys(keys, r.context); err != nil {
+		glog.Errorf("Error prefetching %d keys: %v", len(keys), err)
+	}
+}
+
 // ForEachResourceRecord calls parseRecord for each RR record in DB in provided AND default location
 func (r *sortedDataReader) ForEachResourceRecord(domainName []byte, loc *Location, parseRecord func(result []byte) error) error {
 	var err error
@@ -339,6 +379,10 @@ func (r *sortedDataReader) ForEachResourceRecord(domainName []byte, loc *Locatio
 
 	if !loc.IsEmpty() {
 		copy(key[locationIndex:], loc.LocID[:])
+		// resolve both location variants of the record key in one batched read
+		defaultLocationKey := append([]byte(nil), key...)
+		copy(defaultLocationKey[locationIndex:], EmptyLocation.LocID[:])
+		r.prefetchKeys(key, defaultLocationKey)
 		err = r.ForEach(key, parseRecord)
 		if err != nil {
 			glog.Errorf("Error %v", err)
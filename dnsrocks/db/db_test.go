@@ -118,7 +118,7 @@ func TestDbReload(t *testing.T) {
 	ctrl := gomock.NewController(t)
 	defer ctrl.Finish()
 	mockDbi := getBaseMockDBI(ctrl)
-	oldDb := &DB{dbi: mockDbi}
+	oldDb := newDB(mockDbi)
 	var reloadTimeout = 1 * time.Second
 
 	// Test 1: reload DB with an invalid DB, expect that they are not switched,
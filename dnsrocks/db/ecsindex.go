@@ -0,0 +1,112 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package db
+
+import (
+	"bytes"
+	"fmt"
+	"net"
+	"sort"
+
+	"github.com/facebook/dns/dnsrocks/dnsdata/rdb"
+)
+
+// ecsRangeEntry is one Rearranger range start point: the first address of a
+// range and the location it maps to. Entries are stored by value in a flat
+// sorted slice so a lookup is a binary search over contiguous memory.
+type ecsRangeEntry struct {
+	ip      [net.IPv6len]byte
+	maskLen uint8
+	hasLoc  bool
+	locID   [2]byte
+}
+
+// ecsRangeIndex is an in-memory copy of the ip-map range points produced by
+// Rearranger, keyed by map ID. The range data is small compared to the record
+// data, so holding it in RAM turns every ECS location resolution into a few
+// cache-resident comparisons instead of a RocksDB iterator seek.
+type ecsRangeIndex struct {
+	maps map[string][]ecsRangeEntry
+}
+
+// prefixScanner is the subset of rdb.RDB needed to build the index.
+type prefixScanner interface {
+	ScanPrefix(prefix []byte, f func(key, value []byte) error) error
+}
+
+// newECSRangeIndex builds the index by scanning all ip-map range point keys.
+// Keys arrive in RocksDB order, which matches the lookup order, so the
+// per-map slices are sorted by construction.
+func newECSRangeIndex(scanner prefixScanner) (*ecsRangeIndex, error) {
+	idx := &ecsRangeIndex{maps: make(map[string][]ecsRangeEntry)}
+	prefixLen := len(ipMapRangePointKeyElement)
+	err := scanner.ScanPrefix(ipMapRangePointKeyElement, func(key, value []byte) error {
+		// key layout: prefix, map ID, 16 byte address, 1 byte mask length
+		nmap := len(key) - prefixLen - net.IPv6len - 1
+		if nmap < 0 {
+			return fmt.Errorf("short range point key: length %d, key %v", len(key), key)
+		}
+		mapID := key[prefixLen : prefixLen+nmap]
+
+		var e ecsRangeEntry
+		copy(e.ip[:], key[prefixLen+nmap:])
+		e.maskLen = key[len(key)-1]
+		// chunk is empty for a null location, or holds the 2 byte LocID
+		chunk, _, err := rdb.ReadNextChunk(value)
+		if err != nil {
+			return fmt.Errorf("bad range point value for map %v: %w", mapID, err)
+		}
+		switch len(chunk) {
+		case 0:
+		case 2:
+			e.hasLoc = true
+			copy(e.locID[:], chunk)
+		default:
+			return fmt.Errorf("invalid location length %d, value %v, map %v", len(chunk), chunk, mapID)
+		}
+		idx.maps[string(mapID)] = append(idx.maps[string(mapID)], e)
+		return nil
+	})
+	if err != nil {
+		return nil, err
+	}
+	return idx, nil
+}
+
+// Lookup returns the location and mask length for the range covering ip in
+// the given map, mirroring the semantics of RDB.FindClosest over the range
+// point keys. ok is false when the map is unknown, and loc is nil when the
+// covering range has a null location.
+func (idx *ecsRangeIndex) Lookup(mapID []byte, ip net.IP, maskLen uint8) (loc []byte, mlen uint8, ok bool) {
+	entries := idx.maps[string(mapID)]
+	if len(entries) == 0 {
+		return nil, 0, false
+	}
+	// first entry strictly greater than the request point; Rearranger always
+	// emits a /0 start point, so the preceding entry exists and covers ip
+	i := sort.Search(len(entries), func(i int) bool {
+		if c := bytes.Compare(entries[i].ip[:], ip); c != 0 {
+			return c > 0
+		}
+		return entries[i].maskLen > maskLen
+	})
+	if i == 0 {
+		return nil, 0, false
+	}
+	e := &entries[i-1]
+	if !e.hasLoc {
+		return nil, e.maskLen, true
+	}
+	return e.locID[:], e.maskLen, true
+}
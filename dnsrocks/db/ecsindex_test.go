@@ -0,0 +1,113 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package db
+
+import (
+	"bytes"
+	"encoding/binary"
+	"net"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+// fakeRangeScanner feeds pre-built key/value pairs to the index builder the
+// way RDB.ScanPrefix would.
+type fakeRangeScanner struct {
+	keys   [][]byte
+	values [][]byte
+}
+
+func (s *fakeRangeScanner) ScanPrefix(prefix []byte, f func(key, value []byte) error) error {
+	for i, k := range s.keys {
+		if bytes.HasPrefix(k, prefix) {
+			if err := f(k, s.values[i]); err != nil {
+				return err
+			}
+		}
+	}
+	return nil
+}
+
+func rangePointKey(mapID []byte, ip string, maskLen uint8) []byte {
+	k := append([]byte(nil), ipMapRangePointKeyElement...)
+	k = append(k, mapID...)
+	k = append(k, net.ParseIP(ip).To16()...)
+	return append(k, maskLen)
+}
+
+func rangePointValue(locID []byte) []byte {
+	v := make([]byte, 4+len(locID))
+	binary.LittleEndian.PutUint32(v, uint32(len(locID)))
+	copy(v[4:], locID)
+	return v
+}
+
+func TestECSRangeIndexLookup(t *testing.T) {
+	mapID := []byte{0, 'c'}
+	scanner := &fakeRangeScanner{
+		// sorted, the way the Rearranger output comes out of RocksDB:
+		// a /0 start point, a range for 10.0.0.0/8 and its end point
+		keys: [][]byte{
+			rangePointKey(mapID, "::", 0),
+			rangePointKey(mapID, "::ffff:10.0.0.0", 8+96),
+			rangePointKey(mapID, "::ffff:11.0.0.0", 0),
+		},
+		values: [][]byte{
+			rangePointValue(nil),
+			rangePointValue([]byte{0, 1}),
+			rangePointValue(nil),
+		},
+	}
+	idx, err := newECSRangeIndex(scanner)
+	require.NoError(t, err)
+
+	// inside the range
+	loc, mlen, ok := idx.Lookup(mapID, net.ParseIP("10.1.2.3").To16(), 128)
+	require.True(t, ok)
+	require.Equal(t, []byte{0, 1}, loc)
+	require.Equal(t, uint8(8+96), mlen)
+
+	// exactly on the range start
+	loc, mlen, ok = idx.Lookup(mapID, net.ParseIP("10.0.0.0").To16(), 128)
+	require.True(t, ok)
+	require.Equal(t, []byte{0, 1}, loc)
+	require.Equal(t, uint8(8+96), mlen)
+
+	// before the range: the /0 start point with a null location matches
+	loc, mlen, ok = idx.Lookup(mapID, net.ParseIP("9.255.255.255").To16(), 128)
+	require.True(t, ok)
+	require.Nil(t, loc)
+	require.Equal(t, uint8(0), mlen)
+
+	// after the range end point
+	loc, mlen, ok = idx.Lookup(mapID, net.ParseIP("12.0.0.0").To16(), 128)
+	require.True(t, ok)
+	require.Nil(t, loc)
+	require.Equal(t, uint8(0), mlen)
+
+	// unknown map
+	_, _, ok = idx.Lookup([]byte{0, 'x'}, net.ParseIP("10.1.2.3").To16(), 128)
+	require.False(t, ok)
+}
+
+func TestECSRangeIndexBadValue(t *testing.T) {
+	mapID := []byte{0, 'c'}
+	scanner := &fakeRangeScanner{
+		keys:   [][]byte{rangePointKey(mapID, "::", 0)},
+		values: [][]byte{rangePointValue([]byte{1, 2, 3})},
+	}
+	_, err := newECSRangeIndex(scanner)
+	require.Error(t, err)
+}
@@ -17,6 +17,7 @@ import (
 	"bytes"
 	"fmt"
 	"net"
+	"sync/atomic"
 	"time"
 
 	"github.com/facebook/dns/dnsrocks/dnsdata/rdb"
@@ -29,6 +30,12 @@ type rdbdriver struct {
 	db           *rdb.RDB
 	path         string
 	isDataSorted bool
+	// in-memory copy of the ip-map range points, swapped atomically on
+	// reload; nil when the index could not be built
+	ecsIndex atomic.Pointer[ecsRangeIndex]
+	// in-memory set of zone cuts, swapped atomically on reload; nil when
+	// the data is not sorted or the index could not be built
+	zoneCuts atomic.Pointer[zoneCutIndex]
 }
 
 func openRDB(path string) (DBI, error) {
@@ -40,16 +47,57 @@ func openRDB(path string) (DBI, error) {
 	isDataSorted := db.IsV2KeySyntaxUsed()
 
 	driver := &rdbdriver{db: db, path: path, isDataSorted: isDataSorted}
+	driver.buildECSIndex()
+	driver.buildZoneCutIndex()
 	return driver, nil
 }
 
+// buildECSIndex loads the ip-map range points in RAM so that ECS location
+// resolution is served without a RocksDB seek. On failure the driver keeps
+// working off RocksDB via FindClosest.
+func (r *rdbdriver) buildECSIndex() {
+	idx, err := newECSRangeIndex(r.db)
+	if err != nil {
+		glog.Errorf("failed to build in-memory ECS range index, falling back to RocksDB seeks: %v", err)
+		r.ecsIndex.Store(nil)
+		return
+	}
+	r.ecsIndex.Store(idx)
+}
+
+// buildZoneCutIndex loads the zone cuts in RAM so that authority
+// determination does not probe RocksDB at every ancestor label. Only the v2
+// key syntax marks record keys, so with v1 data (and on build failure) the
+// readers keep walking labels against RocksDB.
+func (r *rdbdriver) buildZoneCutIndex() {
+	if !r.isDataSorted {
+		r.zoneCuts.Store(nil)
+		return
+	}
+	idx, err := newZoneCutIndex(r.db)
+	if err != nil {
+		glog.Errorf("failed to build in-memory zone-cut index, falling back to RocksDB probes: %v", err)
+		r.zoneCuts.Store(nil)
+		return
+	}
+	r.zoneCuts.Store(idx)
+}
+
+// ZoneCuts returns the in-memory zone-cut index, or nil when it is not
+// available for this database.
+func (r *rdbdriver) ZoneCuts() *zoneCutIndex {
+	return r.zoneCuts.Load()
+}
+
 func (r *rdbdriver) NewContext() Context {
 	return rdb.NewContext()
 }
 
 func (r *rdbdriver) FreeContext(context Context) {
+	// Reset releases the RocksDB value pins accumulated during the query,
+	// so record bytes must not be referenced past this point.
 	context.Reset()
-	// could do pooling like CDB but there is no buffer reusing in RocksDB/cgo at the moment - no need to bother now
+	// could do pooling like CDB but contexts are cheap enough - no need to bother now
 }
 
 // Find returns the first data value for the given key as a byte slice.
@@ -171,15 +219,26 @@ func (r *rdbdriver) GetLocationByMap(ipnet *net.IPNet, mapID []byte, context Con
 	// Build key prefix: "\000\000\000!{MapID}"
 	// We prime the key byte array (fullKey) with the key prefix,
 	// followed by the original IP address in V6 format.
+	reqMaskLen, _ := ipnet.Mask.Size()
+	if isIPv4(ipnet.IP) {
+		reqMaskLen += 128 - 32
+	}
+
+	// Fast path: binary search the in-memory range index instead of seeking
+	// in RocksDB.
+	if idx := r.ecsIndex.Load(); idx != nil {
+		loc, mlen, ok := idx.Lookup(mapID, ipnet.IP.To16(), uint8(reqMaskLen))
+		if !ok {
+			return nil, 0, nil
+		}
+		return loc, mlen, nil
+	}
+
 	nmap := len(mapID)
 	fullKey := make([]byte, 4+nmap+net.IPv6len+1) // 4 bytes for prefix, n bytes for mapID, and the rest is IP and masklen
 	copy(fullKey, ipMapRangePointKeyElement)      // prefix, 4 bytes
 	copy(fullKey[4:], mapID)                      // mapID, n bytes
 	copy(fullKey[4+nmap:], ipnet.IP.To16())
-	reqMaskLen, _ := ipnet.Mask.Size()
-	if isIPv4(ipnet.IP) {
-		reqMaskLen += 128 - 32
-	}
 	copy(fullKey[4+nmap+16:], []byte{uint8(reqMaskLen)})
 
 	ctx := context.(*rdb.Context)
@@ -224,6 +283,10 @@ func (r *rdbdriver) Reload(path string) (DBI, error) {
 		if err := r.db.CatchWithPrimary(); err != nil {
 			return nil, err
 		}
+		// Range points and zone cuts may have changed underneath us;
+		// rebuild the indexes.
+		r.buildECSIndex()
+		r.buildZoneCutIndex()
 		reloadTime := time.Now()
 		glog.Infof("Caught up on primary for RocksDB in %v", reloadTime.Sub(start))
 		return r, nil
@@ -262,6 +325,15 @@ func (r *rdbdriver) ForEach(key []byte, f func(value []byte) error, context Cont
 	return r.db.ForEach(key, f, ctx)
 }
 
+// PrefetchKeys resolves all keys in a single batched RocksDB MultiGet and
+// primes the query context, so the per-key Find/ForEach calls that follow
+// do not pay a cgo crossing and a seek each
+func (r *rdbdriver) PrefetchKeys(keys [][]byte, context Context) error {
+	ctx := context.(*rdb.Context)
+
+	return r.db.Prefetch(keys, ctx)
+}
+
 // FindClosestKey searches for closest key which is smaller or equal to provided key
 func (r *rdbdriver) FindClosestKey(key []byte, context Context) ([]byte, error) {
 	k, _, err := r.findClosest(key, context)
@@ -15,26 +15,37 @@ package db
 
 import (
 	"fmt"
-	"math"
 	"net"
+	"sync"
 
 	"github.com/miekg/dns"
 )
 
 // WrsItem Weighted Random Sample Item
 type WrsItem struct {
-	Key  float64
-	TTL  uint32
-	Addr net.IP
+	Weight uint32
+	TTL    uint32
+	Addr   net.IP
 }
 
-// Wrs Weighted Random Sample
+// Wrs Weighted Random Sample.
+// Add collects every candidate record, selection itself happens once per
+// RRset in record(): a Fenwick tree over the weights is built in O(n) and
+// every draw costs O(log n), so adding a record is a plain append instead of
+// a PRNG call and a math.Pow per record as in the previous
+// Efraimidis-Spirakis reservoir. Both schemes are successive weighted draws
+// without replacement, so the answer distribution is unchanged.
 type Wrs struct {
 	MaxAnswers int
 	V4         []WrsItem
 	V4Count    uint32
 	V6         []WrsItem
 	V6Count    uint32
+
+	// selection scratch, recycled through wrsPool
+	tree []float64
+	sel  []WrsItem
+	seen []bool
 }
 
 /*
@@ -45,63 +56,141 @@ than having to do it themselves.
 */
 var localRand = NewRand()
 
-// Add adds a ResourceRecord to Wrs if its randomly computed weight is greater
-// then the existing record.
+// wrsPool recycles Wrs instances between queries so that the per-query item
+// slices reach a steady size and stop hitting the allocator.
+var wrsPool = sync.Pool{
+	New: func() interface{} { return new(Wrs) },
+}
+
+// GetWrs returns an empty Wrs from the pool, configured for maxAnswers.
+func GetWrs(maxAnswers int) *Wrs {
+	w := wrsPool.Get().(*Wrs)
+	w.MaxAnswers = maxAnswers
+	return w
+}
+
+// PutWrs returns w to the pool. The item backing arrays are kept but their
+// elements are cleared so we do not hold on to record buffers between queries.
+// The caller must not use w afterwards.
+func PutWrs(w *Wrs) {
+	w.MaxAnswers = 0
+	clear(w.V4)
+	w.V4 = w.V4[:0]
+	w.V4Count = 0
+	clear(w.V6)
+	w.V6 = w.V6[:0]
+	w.V6Count = 0
+	clear(w.sel)
+	w.sel = w.sel[:0]
+	wrsPool.Put(w)
+}
+
+// Add collects a ResourceRecord as a selection candidate. The weighted
+// draw happens later, when the records are emitted.
 func (w *Wrs) Add(rec ResourceRecord, data []byte) error {
 	if rec.Qtype != dns.TypeA && rec.Qtype != dns.TypeAAAA {
 		return fmt.Errorf("Unsupported type %d", rec.Qtype)
 	}
 
-	key := math.Pow(float64(localRand.Uint32())*float64(1.0/math.MaxUint32), 1.0/float64(rec.Weight))
-	wrsItem := WrsItem{Key: key,
+	wrsItem := WrsItem{Weight: rec.Weight,
 		TTL:  rec.TTL,
 		Addr: data[rec.Offset:]}
-	addRecord := func(items []WrsItem) []WrsItem {
-		if len(items) < w.MaxAnswers {
-			items = append(items, wrsItem)
-		} else {
-			minKey := key
-			idx := -1
-			for i, v := range items {
-				if v.Key < minKey {
-					minKey = v.Key
-					idx = i
-				}
-			}
-			if idx != -1 {
-				items[idx] = wrsItem
-			}
-		}
-		return items
-	}
-	checkAndReplaceRecord := func(items []WrsItem) []WrsItem {
-		if len(items) == 0 {
-			items = append(items, wrsItem)
-		} else if wrsItem.Key > items[0].Key {
-			items[0] = wrsItem
-		}
-		return items
-	}
 
 	if rec.Qtype == dns.TypeA {
 		w.V4Count++
-		if w.MaxAnswers == 1 {
-			w.V4 = checkAndReplaceRecord(w.V4)
-		} else {
-			w.V4 = addRecord(w.V4)
-		}
+		w.V4 = append(w.V4, wrsItem)
 	}
 	if rec.Qtype == dns.TypeAAAA {
 		w.V6Count++
-		if w.MaxAnswers == 1 {
-			w.V6 = checkAndReplaceRecord(w.V6)
-		} else {
-			w.V6 = addRecord(w.V6)
-		}
+		w.V6 = append(w.V6, wrsItem)
 	}
 	return nil
 }
 
+// sample fills w.sel with up to k items drawn without replacement, each draw
+// picking an item with probability proportional to its remaining weight. The
+// Fenwick (binary indexed) tree over the weights is built in O(n) and every
+// draw, including removing the winner's weight, is O(log n), so selection
+// stays cheap on load-balanced names with hundreds of weighted records.
+func (w *Wrs) sample(items []WrsItem, k int) []WrsItem {
+	n := len(items)
+	w.sel = w.sel[:0]
+	if k >= n {
+		w.sel = append(w.sel, items...)
+		localRand.Shuffle(len(w.sel), func(i, j int) {
+			w.sel[i], w.sel[j] = w.sel[j], w.sel[i]
+		})
+		return w.sel
+	}
+
+	var total float64
+	for _, item := range items {
+		total += float64(item.Weight)
+	}
+	// An all-zero RRset degrades to a uniform draw.
+	uniform := total == 0
+	weight := func(i int) float64 {
+		if uniform {
+			return 1
+		}
+		return float64(items[i].Weight)
+	}
+	if uniform {
+		total = float64(n)
+	}
+
+	if cap(w.tree) < n+1 {
+		w.tree = make([]float64, n+1)
+	} else {
+		w.tree = w.tree[:n+1]
+		clear(w.tree)
+	}
+	if cap(w.seen) < n {
+		w.seen = make([]bool, n)
+	} else {
+		w.seen = w.seen[:n]
+		clear(w.seen)
+	}
+	for i := 1; i <= n; i++ {
+		w.tree[i] += weight(i - 1)
+		if j := i + (i & -i); j <= n {
+			w.tree[j] += w.tree[i]
+		}
+	}
+	highBit := 1
+	for highBit<<1 <= n {
+		highBit <<= 1
+	}
+
+	// The attempt cap only guards against pathological floating point
+	// residue re-selecting an already drawn, weight-removed item.
+	for attempts := 8*k + 16; len(w.sel) < k && attempts > 0; attempts-- {
+		r := localRand.Float64() * total
+		pos := 0
+		for bit := highBit; bit > 0; bit >>= 1 {
+			if next := pos + bit; next <= n && w.tree[next] <= r {
+				r -= w.tree[next]
+				pos = next
+			}
+		}
+		if pos >= n {
+			pos = n - 1
+		}
+		if w.seen[pos] {
+			continue
+		}
+		w.seen[pos] = true
+		w.sel = append(w.sel, items[pos])
+		// remove the winner's weight so the next draw excludes it
+		removed := weight(pos)
+		for j := pos + 1; j <= n; j += j & -j {
+			w.tree[j] -= removed
+		}
+		total -= removed
+	}
+	return w.sel
+}
+
 func (w *Wrs) record(name string, class uint16, qtype uint16) (rrs []dns.RR, err error) {
 	var items []WrsItem
 	switch qtype {
@@ -112,16 +201,24 @@ func (w *Wrs) record(name string, class uint16, qtype uint16) (rrs []dns.RR, err
 	default:
 		return nil, fmt.Errorf("Unsupported type %d", qtype)
 	}
-	localRand.Shuffle(len(items), func(i, j int) {
-		items[i], items[j] = items[j], items[i]
-	})
+	selected := w.sample(items, w.MaxAnswers)
 
-	rrs = make([]dns.RR, len(items))
-	for i, item := range items {
+	// The row already stores the rdata in wire format, so A/AAAA records
+	// are built directly instead of going through the generic unpack
+	// machinery of UnpackRRWithHeader - for the largest weighted RRsets
+	// that generic dispatch is pure per-record overhead. The address bytes
+	// are copied: the item may alias a DB row buffer that does not outlive
+	// the query.
+	rrs = make([]dns.RR, len(selected))
+	for i, item := range selected {
 		hdr := dns.RR_Header{Name: name, Rrtype: qtype, Class: class, Ttl: item.TTL, Rdlength: uint16(len(item.Addr))}
-		rrs[i], _, err = dns.UnpackRRWithHeader(hdr, item.Addr, 0)
-		if err != nil {
-			return nil, fmt.Errorf("failed to convert from tinydns format %d, %d: %w", hdr.Rdlength, len(item.Addr), err)
+		switch {
+		case qtype == dns.TypeA && len(item.Addr) == net.IPv4len:
+			rrs[i] = &dns.A{Hdr: hdr, A: append(net.IP(nil), item.Addr...)}
+		case qtype == dns.TypeAAAA && len(item.Addr) == net.IPv6len:
+			rrs[i] = &dns.AAAA{Hdr: hdr, AAAA: append(net.IP(nil), item.Addr...)}
+		default:
+			return nil, fmt.Errorf("failed to convert from tinydns format %d, %d: bad address length", hdr.Rdlength, len(item.Addr))
 		}
 	}
 
@@ -140,5 +237,5 @@ func (w *Wrs) AAAARecord(name string, class uint16) (rrs []dns.RR, err error) {
 
 // WeightedAnswer returns true if the answer selected a subset of possible results.
 func (w *Wrs) WeightedAnswer() bool {
-	return int(w.V4Count) > len(w.V4) || int(w.V6Count) > len(w.V6)
+	return int(w.V4Count) > w.MaxAnswers || int(w.V6Count) > w.MaxAnswers
 }
@@ -52,6 +52,63 @@ func TestWeightedAnswer2(t *testing.T) {
 	require.True(t, wrs.WeightedAnswer())
 }
 
+func TestWrsPoolReuse(t *testing.T) {
+	wrs := GetWrs(2)
+	err := wrs.Add(ResourceRecord{Weight: 1, Qtype: dns.TypeA}, nil)
+	require.NoError(t, err)
+	err = wrs.Add(ResourceRecord{Weight: 1, Qtype: dns.TypeAAAA}, nil)
+	require.NoError(t, err)
+	PutWrs(wrs)
+	// A recycled Wrs must come back empty.
+	wrs = GetWrs(1)
+	require.Equal(t, 1, wrs.MaxAnswers)
+	require.Empty(t, wrs.V4)
+	require.Zero(t, wrs.V4Count)
+	require.Empty(t, wrs.V6)
+	require.Zero(t, wrs.V6Count)
+	require.False(t, wrs.WeightedAnswer())
+	PutWrs(wrs)
+}
+
+func TestWrsRecordMatchesGenericUnpack(t *testing.T) {
+	testCases := []struct {
+		qtype uint16
+		addr  []byte
+	}{
+		{dns.TypeA, []byte{192, 0, 2, 1}},
+		{dns.TypeAAAA, append([]byte{0x20, 0x01, 0x0d, 0xb8}, make([]byte, 12)...)},
+	}
+	for _, tc := range testCases {
+		wrs := Wrs{MaxAnswers: 1}
+		row := make([]byte, 0, 32)
+		row = append(row, byte(tc.qtype>>8), byte(tc.qtype), '=')
+		row = append(row, 0, 0, 1, 44)            // ttl
+		row = append(row, 0, 0, 0, 0, 0, 0, 0, 0) // ttd
+		row = append(row, 0, 0, 0, 100)           // weight
+		row = append(row, tc.addr...)
+		rec, err := ExtractRRFromRow(row, false)
+		require.NoError(t, err)
+		require.NoError(t, wrs.Add(rec, row))
+
+		rrs, err := wrs.record("foo.example.com.", dns.ClassINET, tc.qtype)
+		require.NoError(t, err)
+		require.Len(t, rrs, 1)
+
+		hdr := dns.RR_Header{Name: "foo.example.com.", Rrtype: tc.qtype, Class: dns.ClassINET, Ttl: 300, Rdlength: uint16(len(tc.addr))}
+		want, _, err := dns.UnpackRRWithHeader(hdr, tc.addr, 0)
+		require.NoError(t, err)
+		require.Equal(t, want.String(), rrs[0].String())
+	}
+}
+
+func TestWrsRecordRejectsBadAddressLength(t *testing.T) {
+	wrs := Wrs{MaxAnswers: 1}
+	err := wrs.Add(ResourceRecord{Weight: 1, Qtype: dns.TypeA, Offset: 0}, []byte{192, 0, 2})
+	require.NoError(t, err)
+	_, err = wrs.record("foo.example.com.", dns.ClassINET, dns.TypeA)
+	require.Error(t, err)
+}
+
 func BenchmarkAdd(b *testing.B) {
 	testCases := []struct {
 		numAnswers int
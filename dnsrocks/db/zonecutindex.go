@@ -0,0 +1,126 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package db
+
+import (
+	"github.com/facebook/dns/dnsrocks/dnsdata"
+	"github.com/facebook/dns/dnsrocks/dnsdata/rdb"
+
+	"github.com/miekg/dns"
+)
+
+// zoneCutFlags records what a zone cut carries: NS records mean we either
+// serve or delegate the zone, SOA means we are authoritative for it.
+type zoneCutFlags struct {
+	ns   bool
+	auth bool
+}
+
+// zoneCutIndex is the in-memory set of zone cuts, keyed by the 2 byte LocID
+// followed by the packed zone name. The set is tiny compared to the record
+// data and changes only on reload, so holding it in RAM makes authority
+// determination a pure in-memory suffix walk: only the final answer lookup
+// still touches the storage backend.
+type zoneCutIndex struct {
+	cuts map[string]zoneCutFlags
+}
+
+// newZoneCutIndex builds the index by scanning every resource record key and
+// keeping the names that own NS or SOA records. It only understands the v2
+// key syntax, where record keys carry a dedicated marker and the location as
+// a suffix; v1 keys cannot be told apart from the other key families.
+func newZoneCutIndex(scanner prefixScanner) (*zoneCutIndex, error) {
+	idx := &zoneCutIndex{cuts: make(map[string]zoneCutFlags)}
+	markerLen := len(dnsdata.ResourceRecordsKeyMarker)
+	err := scanner.ScanPrefix([]byte(dnsdata.ResourceRecordsKeyMarker), func(key, value []byte) error {
+		// key layout: marker, reversed packed name, 2 byte LocID
+		if string(key) == dnsdata.FeaturesKey {
+			return nil
+		}
+		if len(key) < markerLen+1+2 {
+			// short keys cannot hold a name and a location; skip rather than
+			// fail the whole build on an unrelated key shape
+			return nil
+		}
+		var flags zoneCutFlags
+		for len(value) > 0 {
+			chunk, rest, err := rdb.ReadNextChunk(value)
+			if err != nil {
+				return err
+			}
+			value = rest
+			rec, err := ExtractRRFromRow(chunk, false)
+			if err != nil {
+				continue
+			}
+			switch rec.Qtype {
+			case dns.TypeNS:
+				flags.ns = true
+			case dns.TypeSOA:
+				flags.auth = true
+			}
+		}
+		if !flags.ns && !flags.auth {
+			return nil
+		}
+		locID := key[len(key)-2:]
+		name := reverseZoneName(key[markerLen : len(key)-2])
+		mapKey := make([]byte, 0, len(name)+2)
+		mapKey = append(mapKey, locID...)
+		mapKey = append(mapKey, name...)
+		cut := idx.cuts[string(mapKey)]
+		cut.ns = cut.ns || flags.ns
+		cut.auth = cut.auth || flags.auth
+		idx.cuts[string(mapKey)] = cut
+		return nil
+	})
+	if err != nil {
+		return nil, err
+	}
+	return idx, nil
+}
+
+// IsAuthoritative mirrors DataReader.IsAuthoritative against the in-memory
+// set: starting from q it pops one label at a time, probing the location
+// specific and the location-less entry at each cut, until it finds NS
+// records or runs out of labels.
+func (idx *zoneCutIndex) IsAuthoritative(q []byte, loc *Location) (ns bool, auth bool, zoneCut []byte) {
+	zoneCut = q
+	probeKey := make([]byte, 0, len(q)+2)
+	probe := func(locID []byte) {
+		probeKey = append(probeKey[:0], locID...)
+		probeKey = append(probeKey, zoneCut...)
+		if flags, ok := idx.cuts[string(probeKey)]; ok {
+			ns = ns || flags.ns
+			auth = auth || flags.auth
+		}
+	}
+
+	for {
+		if !loc.IsEmpty() {
+			probe(loc.LocID[:])
+		}
+		if !(auth && ns) {
+			probe(EmptyLocation.LocID[:])
+		}
+		if ns {
+			break
+		}
+		if zoneCut[0] == 0 {
+			break
+		}
+		zoneCut = zoneCut[1+zoneCut[0]:]
+	}
+	return
+}
@@ -0,0 +1,111 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package db
+
+import (
+	"encoding/binary"
+	"testing"
+
+	"github.com/facebook/dns/dnsrocks/dnsdata"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+)
+
+// zoneCutKey builds a v2 resource record key: marker, reversed packed name,
+// LocID suffix.
+func zoneCutKey(packedName []byte, locID []byte) []byte {
+	k := append([]byte(nil), dnsdata.ResourceRecordsKeyMarker...)
+	k = append(k, reverseZoneName(packedName)...)
+	return append(k, locID...)
+}
+
+// zoneCutValue serializes rows with the given qtypes into the multi-value
+// format stored in RDB.
+func zoneCutValue(qtypes ...uint16) []byte {
+	var v []byte
+	for _, qtype := range qtypes {
+		// qtype (2), ch, ttl (4), ttd (8): the smallest row
+		// ExtractRRFromRow accepts
+		row := make([]byte, 15)
+		binary.BigEndian.PutUint16(row, qtype)
+		row[2] = '='
+		var b [4]byte
+		binary.LittleEndian.PutUint32(b[:], uint32(len(row)))
+		v = append(v, b[:]...)
+		v = append(v, row...)
+	}
+	return v
+}
+
+func TestZoneCutIndexIsAuthoritative(t *testing.T) {
+	var (
+		exampleCom       = []byte("\x07example\x03com\x00")
+		subExampleCom    = []byte("\x03sub\x07example\x03com\x00")
+		wwwExampleCom    = []byte("\x03www\x07example\x03com\x00")
+		wwwSubExampleCom = []byte("\x03www\x03sub\x07example\x03com\x00")
+		otherOrg         = []byte("\x05other\x03org\x00")
+		locID            = []byte{0, 2}
+	)
+	scanner := &fakeRangeScanner{
+		keys: [][]byte{
+			zoneCutKey(exampleCom, EmptyLocation.LocID[:]),
+			zoneCutKey(subExampleCom, EmptyLocation.LocID[:]),
+			zoneCutKey(subExampleCom, locID),
+		},
+		values: [][]byte{
+			zoneCutValue(dns.TypeNS, dns.TypeSOA),
+			// delegation for the default location
+			zoneCutValue(dns.TypeNS),
+			// location override serving the zone
+			zoneCutValue(dns.TypeNS, dns.TypeSOA),
+		},
+	}
+	idx, err := newZoneCutIndex(scanner)
+	require.NoError(t, err)
+
+	// inside the authoritative zone
+	ns, auth, zoneCut := idx.IsAuthoritative(wwwExampleCom, &EmptyLocation)
+	require.True(t, ns)
+	require.True(t, auth)
+	require.Equal(t, exampleCom, zoneCut)
+
+	// below the delegation
+	ns, auth, zoneCut = idx.IsAuthoritative(wwwSubExampleCom, &EmptyLocation)
+	require.True(t, ns)
+	require.False(t, auth)
+	require.Equal(t, subExampleCom, zoneCut)
+
+	// the location override is authoritative for the delegated zone
+	loc := &Location{MapID: []byte{0, 1}, LocID: locID}
+	ns, auth, zoneCut = idx.IsAuthoritative(wwwSubExampleCom, loc)
+	require.True(t, ns)
+	require.True(t, auth)
+	require.Equal(t, subExampleCom, zoneCut)
+
+	// outside any zone we know of
+	ns, auth, _ = idx.IsAuthoritative(otherOrg, &EmptyLocation)
+	require.False(t, ns)
+	require.False(t, auth)
+}
+
+func TestZoneCutIndexSkipsFeaturesKey(t *testing.T) {
+	scanner := &fakeRangeScanner{
+		keys:   [][]byte{[]byte(dnsdata.FeaturesKey)},
+		values: [][]byte{[]byte(`{"usev2keys":true}`)},
+	}
+	idx, err := newZoneCutIndex(scanner)
+	require.NoError(t, err)
+	require.Empty(t, idx.cuts)
+}
@@ -27,6 +27,8 @@ import (
 
 // CreatorOptions provides options to create CDB
 type CreatorOptions struct {
+	// NumCPU is the number of workers used both for parsing the input data
+	// and for building the 256 hash tables on close, 0 meaning one per CPU
 	NumCPU int
 }
 
@@ -60,7 +62,7 @@ func CreateCDB(ipath string, opath string, options *CreatorOptions) (mw int, err
 		}
 	}()
 
-	db, err := cdb.NewWriter(opath)
+	db, err := cdb.NewParallelWriter(opath, options.NumCPU)
 	if err != nil {
 		return 0, errors.Wrapf(err, "can't create output database")
 	}
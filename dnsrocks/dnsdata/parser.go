@@ -36,17 +36,23 @@ func getWorkers(workers int) (int, error) {
 
 // ParseStream parses data from io.Reader and returns results via results chan.
 // Data is parsed in parallel when workers != 1.
+// Results arrive batched: one slice carries the records of a whole chunk of
+// input lines, so the channel traffic does not scale with the line count.
 func ParseStream(r io.Reader, codec *Codec, results chan<- []MapRecord, workers int) error {
 	defer close(results)
 
 	err := parse(
 		r,
-		func(line []byte) error {
-			v, err := codec.ConvertLn(line)
-			if err != nil {
-				return fmt.Errorf("Conversion failed for line '%s': %w", line, err)
+		func(lines [][]byte) error {
+			out := make([]MapRecord, 0, len(lines))
+			for _, line := range lines {
+				v, err := codec.ConvertLn(line)
+				if err != nil {
+					return fmt.Errorf("Conversion failed for line '%s': %w", line, err)
+				}
+				out = append(out, v...)
 			}
-			results <- v
+			results <- out
 			return nil
 		},
 		workers)
@@ -79,18 +85,25 @@ func ParseRecords(r io.Reader, codec *Codec, results chan<- Record, workers int)
 
 	return parse(
 		r,
-		func(line []byte) error {
-			v, err := codec.DecodeLn(line)
-			if err != nil {
-				return fmt.Errorf("parsing failed for line '%s': %w", line, err)
+		func(lines [][]byte) error {
+			for _, line := range lines {
+				v, err := codec.DecodeLn(line)
+				if err != nil {
+					return fmt.Errorf("parsing failed for line '%s': %w", line, err)
+				}
+				results <- v
 			}
-			results <- v
 			return nil
 		},
 		workers)
 }
 
-func parse(r io.Reader, process func([]byte) error, workers int) error {
+// parseChunkLines is the number of input lines handed to a parser worker at
+// once. Dispatching chunks instead of single lines amortizes the channel and
+// scheduling overhead, which otherwise dominates on multi-GB inputs.
+const parseChunkLines = 512
+
+func parse(r io.Reader, process func(lines [][]byte) error, workers int) error {
 	workers, err := getWorkers(workers)
 	if err != nil {
 		return err
@@ -101,12 +114,12 @@ func parse(r io.Reader, process func([]byte) error, workers int) error {
 	scanner.Split(bufio.ScanLines)
 
 	var g errgroup.Group
-	c := make(chan []byte, workers*10) // 10 came out of experiments, allows some buffering
+	c := make(chan [][]byte, workers*2)
 
 	for i := 0; i < workers; i++ {
 		g.Go(func() error {
-			for line := range c {
-				if err := process(line); err != nil {
+			for chunk := range c {
+				if err := process(chunk); err != nil {
 					return err
 				}
 			}
@@ -120,6 +133,7 @@ func parse(r io.Reader, process func([]byte) error, workers int) error {
 	go func() {
 		defer wg.Done()
 		defer close(c)
+		chunk := make([][]byte, 0, parseChunkLines)
 		for scanner.Scan() {
 			line := bytes.TrimLeft(scanner.Bytes(), " ")
 			if len(line) < 2 || bytes.HasPrefix(line, []byte("#")) {
@@ -127,7 +141,14 @@ func parse(r io.Reader, process func([]byte) error, workers int) error {
 			}
 			newLine := make([]byte, len(line))
 			copy(newLine, line)
-			c <- newLine
+			chunk = append(chunk, newLine)
+			if len(chunk) == parseChunkLines {
+				c <- chunk
+				chunk = make([][]byte, 0, parseChunkLines)
+			}
+		}
+		if len(chunk) > 0 {
+			c <- chunk
 		}
 	}()
 
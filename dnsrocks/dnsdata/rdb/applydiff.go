@@ -19,11 +19,19 @@ import (
 	"fmt"
 	"io"
 	"os"
+	"runtime"
+	"sync"
+
+	"golang.org/x/sync/errgroup"
 
 	"github.com/facebook/dns/dnsrocks/dnsdata"
 	"github.com/facebook/dns/dnsrocks/dnsdata/rdb/dbdiff"
 )
 
+// diffChunkLines is the number of diff lines handed to a conversion worker
+// at once, amortizing channel overhead the same way the parser does
+const diffChunkLines = 512
+
 func (batch *Batch) ApplyDiff(d *dbdiff.Entry) {
 	for _, r := range d.Records {
 		switch d.Op {
@@ -35,28 +43,77 @@ func (batch *Batch) ApplyDiff(d *dbdiff.Entry) {
 	}
 }
 
+// ApplyDiff parses and applies a diff. Conversion of the diff lines runs
+// across worker goroutines, each collecting into its own sub-batch; the order
+// in which adds and deletes are collected does not matter, because integration
+// resolves them per key and value. The merged batch is then applied by
+// ExecuteBatch, which shards large batches on its own.
 func (rdb *RDB) ApplyDiff(r io.Reader, serial uint32) error {
 	codec := initCodec(serial)
 	codec.Features.UseV2Keys = rdb.IsV2KeySyntaxUsed()
 	batch := rdb.CreateBatch()
+
+	workers := runtime.NumCPU()
+	c := make(chan [][]byte, workers*2)
+	batches := make([]*Batch, workers)
+
+	var g errgroup.Group
+	for i := 0; i < workers; i++ {
+		wb := rdb.CreateBatch()
+		batches[i] = wb
+		g.Go(func() error {
+			for chunk := range c {
+				for _, line := range chunk {
+					e := new(dbdiff.Entry)
+					if err := e.ParseBytes(line); err != nil {
+						return fmt.Errorf("parse error for input line '%s': %w", line, err)
+					}
+					if err := e.Convert(codec); err != nil {
+						return fmt.Errorf("conversion error for line '%s' (op '%v'): %w", e.Bytes, e.Op, err)
+					}
+					wb.ApplyDiff(e)
+				}
+			}
+			return nil
+		})
+	}
+
 	scanner := bufio.NewScanner(r)
-	for scanner.Scan() {
-		line := scanner.Bytes()
-		if len(line) < 1 || bytes.HasPrefix(line, []byte("#")) {
-			continue
+	var wg sync.WaitGroup
+	wg.Add(1)
+	go func() {
+		defer wg.Done()
+		defer close(c)
+		chunk := make([][]byte, 0, diffChunkLines)
+		for scanner.Scan() {
+			line := scanner.Bytes()
+			if len(line) < 1 || bytes.HasPrefix(line, []byte("#")) {
+				continue
+			}
+			newLine := make([]byte, len(line))
+			copy(newLine, line)
+			chunk = append(chunk, newLine)
+			if len(chunk) == diffChunkLines {
+				c <- chunk
+				chunk = make([][]byte, 0, diffChunkLines)
+			}
 		}
-		e := new(dbdiff.Entry)
-		if err := e.ParseBytes(line); err != nil {
-			return fmt.Errorf("parse error for input line '%s': %w", line, err)
+		if len(chunk) > 0 {
+			c <- chunk
 		}
-		if err := e.Convert(codec); err != nil {
-			return fmt.Errorf("conversion error for line '%s' (op '%v'): %w", e.Bytes, e.Op, err)
-		}
-		batch.ApplyDiff(e)
+	}()
+
+	if err := g.Wait(); err != nil {
+		return err
 	}
+	wg.Wait()
 	if err := scanner.Err(); err != nil {
 		return err
 	}
+
+	for _, wb := range batches {
+		batch.merge(wb)
+	}
 	if err := rdb.ExecuteBatch(batch); err != nil {
 		return fmt.Errorf("database update failed: %w", err)
 	}
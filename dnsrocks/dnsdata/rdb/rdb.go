@@ -24,6 +24,9 @@ import (
 	"runtime"
 	"strconv"
 	"sync"
+	"sync/atomic"
+
+	"golang.org/x/sync/errgroup"
 
 	rocksdb "github.com/facebook/dns/dnsrocks/cgo-rocksdb"
 	"github.com/facebook/dns/dnsrocks/dnsdata"
@@ -39,6 +42,13 @@ const DefaultBatchNum = 10
 const (
 	defaultBloomFilterBits = 10
 	defaultBlockCacheMB    = 8
+	// fixed-size prefix extractor covering the key marker and the first
+	// bytes of the reversed zone name, so memtable and SST prefix bloom
+	// filters can rule out whole files on negative and short-range scans;
+	// 0 disables prefix handling
+	defaultPrefixExtractorLen = 10
+	// memtable prefix bloom filter size, in % of the write buffer size
+	defaultMemtablePrefixBloomPct = 2
 	// compaction
 	defaultWriteBufferSizeMB               = 128
 	defaultTargetFileSizeBaseMB            = 64
@@ -57,9 +67,11 @@ const Mb = 1 << 20
 type DBI interface {
 	Put(writeOptions *rocksdb.WriteOptions, key, value []byte) error
 	Get(readOptions *rocksdb.ReadOptions, key []byte) ([]byte, error)
+	GetPinned(readOptions *rocksdb.ReadOptions, key []byte) (*rocksdb.PinnableSlice, error)
 	Delete(writeOptions *rocksdb.WriteOptions, key []byte) error
 	NewBatch() *rocksdb.Batch
 	GetMulti(readOptions *rocksdb.ReadOptions, keys [][]byte) ([][]byte, []error)
+	GetMultiPinned(readOptions *rocksdb.ReadOptions, keys [][]byte) ([]*rocksdb.PinnableSlice, []error)
 	ExecuteBatch(batch *rocksdb.Batch, writeOptions *rocksdb.WriteOptions) error
 	IngestSSTFiles(fileNames []string, useHardlinks bool) error
 	Flush() error
@@ -80,13 +92,22 @@ type RDB struct {
 	writeOptions *rocksdb.WriteOptions
 	logDir       string // RocksDB log output directory
 	secondary    bool   // DB open in secondary mode
+	// length of the fixed-size prefix extractor set on the database, 0 when
+	// prefix handling is disabled
+	prefixLen int
+	// read options for prefix-mode iterators (prefix_same_as_start); nil
+	// when prefix handling is disabled
+	prefixReadOptions *rocksdb.ReadOptions
 
 	iteratorPool *IteratorPool
 }
 
-// Context is a structure holding the state between calls to DB
+// Context is a structure holding the state between calls to DB.
+// It also owns the RocksDB value pins acquired during the look-up cycle,
+// which keep cached values readable in place without copying them out.
 type Context struct {
-	cache map[string]contextCacheEntry
+	cache  map[string]contextCacheEntry
+	pinned []*rocksdb.PinnableSlice
 }
 
 type contextCacheEntry struct {
@@ -114,6 +135,7 @@ func NewRDB(path string) (*RDB, error) {
 	options.OptimizeLevelStyleCompaction(0)
 	options.SetFullBloomFilter(10)    // 10 bits
 	options.SetLRUCacheSize(128 * Mb) // 128 Mb
+	setPrefixExtractor(options)
 
 	db, err := rocksdb.OpenDatabase(path, false, false, options)
 	if err != nil {
@@ -125,17 +147,22 @@ func NewRDB(path string) (*RDB, error) {
 		false, true, true, false, false,
 	)
 	readOptions := rocksdb.NewDefaultReadOptions()
+	// the pooled iterators serve FindClosest and must keep total order
+	// semantics despite the prefix extractor
+	readOptions.SetTotalOrderSeek(true)
 
 	iteratorPool := newIteratorPool(func() *rocksdb.Iterator { return db.CreateIterator(readOptions) })
 	iteratorPool.enable()
 
 	return &RDB{
-		db:           db,
-		writeMutex:   &sync.Mutex{},
-		readOptions:  readOptions,
-		writeOptions: writeOptions,
-		logDir:       path,
-		iteratorPool: iteratorPool,
+		db:                db,
+		writeMutex:        &sync.Mutex{},
+		readOptions:       readOptions,
+		writeOptions:      writeOptions,
+		logDir:            path,
+		prefixLen:         prefixExtractorLen(),
+		prefixReadOptions: newPrefixReadOptions(),
+		iteratorPool:      iteratorPool,
 	}, nil
 }
 
@@ -153,6 +180,37 @@ func getEnvVar(key string, defaultValue int) int {
 	return i
 }
 
+// prefixExtractorLen returns the fixed prefix extractor length, including a
+// potential override from ENV; 0 disables prefix handling
+func prefixExtractorLen() int {
+	return getEnvVar("FBDNS_ROCKSDB_PREFIX_EXTRACTOR_LEN", defaultPrefixExtractorLen)
+}
+
+// setPrefixExtractor wires a fixed-size prefix extractor and the memtable
+// prefix bloom filter into options. Combined with the full bloom filter this
+// also makes SST files carry prefix bloom filters, so prefix-mode iterators
+// can skip whole files.
+func setPrefixExtractor(options *rocksdb.Options) {
+	prefixLen := prefixExtractorLen()
+	if prefixLen <= 0 {
+		return
+	}
+	options.SetPrefixExtractorSize(prefixLen)
+	bloomPct := getEnvVar("FBDNS_ROCKSDB_MEMTABLE_PREFIX_BLOOM_PCT", defaultMemtablePrefixBloomPct)
+	options.SetMemtablePrefixBloomSizeRatio(float64(bloomPct) / 100)
+}
+
+// newPrefixReadOptions returns read options for prefix-mode iterators, or
+// nil when prefix handling is disabled
+func newPrefixReadOptions() *rocksdb.ReadOptions {
+	if prefixExtractorLen() <= 0 {
+		return nil
+	}
+	readOptions := rocksdb.NewDefaultReadOptions()
+	readOptions.SetPrefixSameAsStart(true)
+	return readOptions
+}
+
 // DefaultOptions returns rocksdb Options initialized with DNSROCKS default values, including potential overrides from ENV variables.
 func DefaultOptions() *rocksdb.Options {
 	options := rocksdb.NewOptions()
@@ -160,6 +218,7 @@ func DefaultOptions() *rocksdb.Options {
 	options.SetFullBloomFilter(bloom)
 	blockCache := getEnvVar("FBDNS_ROCKSDB_BLOCK_CACHE_MB", defaultBlockCacheMB)
 	options.SetLRUCacheSize(blockCache * Mb) // N mb
+	setPrefixExtractor(options)
 
 	// directions for compaction fine-tuning (based on https://github.com/facebook/rocksdb/wiki/RocksDB-Tuning-Guide)
 	// We can estimate level 0 size in stable state as write_buffer_size * min_write_buffer_number_to_merge * level0_file_num_compaction_trigger
@@ -222,16 +281,21 @@ func NewReader(path string) (*RDB, error) {
 		return nil, err
 	}
 	readOptions := rocksdb.NewDefaultReadOptions()
+	// the pooled iterators serve FindClosest and must keep total order
+	// semantics despite the prefix extractor
+	readOptions.SetTotalOrderSeek(true)
 
 	iteratorPool := newIteratorPool(func() *rocksdb.Iterator { return db.CreateIterator(readOptions) })
 	iteratorPool.enable()
 
 	return &RDB{
-		db:           db,
-		readOptions:  readOptions,
-		logDir:       logDir,
-		secondary:    true,
-		iteratorPool: iteratorPool,
+		db:                db,
+		readOptions:       readOptions,
+		logDir:            logDir,
+		secondary:         true,
+		prefixLen:         prefixExtractorLen(),
+		prefixReadOptions: newPrefixReadOptions(),
+		iteratorPool:      iteratorPool,
 	}, nil
 }
 
@@ -259,6 +323,7 @@ func NewUpdater(dbpath string) (*RDB, error) {
 	// We disable WAL because there is a known bug with CatchWithPrimary when it's enabled - T59258592
 	wopt := rocksdb.NewWriteOptions(false, true, true, false, false)
 	ropt := rocksdb.NewDefaultReadOptions()
+	ropt.SetTotalOrderSeek(true)
 	rdb := &RDB{
 		db:           db,
 		writeMutex:   &sync.Mutex{},
@@ -376,6 +441,10 @@ func (rdb *RDB) Del(key, value []byte) error {
 	return rdb.db.Put(rdb.writeOptions, key, newData)
 }
 
+// executeBatchShardMin is the number of affected keys from which ExecuteBatch
+// spreads the read and integration work over all CPUs
+const executeBatchShardMin = 65536
+
 // ExecuteBatch will apply all operations from the batch. The same batch
 // cannot be applied twice.
 func (rdb *RDB) ExecuteBatch(batch *Batch) error {
@@ -388,6 +457,11 @@ func (rdb *RDB) ExecuteBatch(batch *Batch) error {
 	// lock is needed, because between getting and updating values there might be a race
 	rdb.writeMutex.Lock()
 	defer rdb.writeMutex.Unlock()
+
+	if len(uniqueKeys) >= executeBatchShardMin && runtime.NumCPU() > 1 {
+		return rdb.executeBatchSharded(batch, uniqueKeys)
+	}
+
 	dbValues, errors := rdb.db.GetMulti(rdb.readOptions, uniqueKeys)
 	for _, err := range errors {
 		if err != nil {
@@ -416,6 +490,75 @@ func (rdb *RDB) ExecuteBatch(batch *Batch) error {
 	return rdb.db.ExecuteBatch(dbBatch, rdb.writeOptions)
 }
 
+// executeBatchSharded splits the affected keys into contiguous shards and has
+// one worker per shard fetch the current values with GetMulti, integrate the
+// batch contents and assemble its own WriteBatch, so apply time scales with
+// cores instead of batch size. The shard write batches are committed one
+// after another rather than as a single atomic write; callers treat a failed
+// apply as fatal and rebuild, so this is an acceptable trade.
+// Must be called with writeMutex held.
+func (rdb *RDB) executeBatchSharded(batch *Batch, uniqueKeys [][]byte) error {
+	shards := runtime.NumCPU()
+	shardSize := (len(uniqueKeys) + shards - 1) / shards
+
+	dbBatches := make([]*rocksdb.Batch, 0, shards)
+	defer func() {
+		for _, dbBatch := range dbBatches {
+			dbBatch.Destroy()
+		}
+	}()
+
+	var g errgroup.Group
+	var aConsumed, dConsumed atomic.Int64
+	for lo := 0; lo < len(uniqueKeys); lo += shardSize {
+		hi := min(lo+shardSize, len(uniqueKeys))
+		keys := uniqueKeys[lo:hi]
+		dbBatch := rdb.db.NewBatch()
+		dbBatches = append(dbBatches, dbBatch)
+		g.Go(func() error {
+			dbValues, errs := rdb.db.GetMulti(rdb.readOptions, keys)
+			for _, err := range errs {
+				if err != nil {
+					return err // return the first error that had happened in GetMulti()
+				}
+			}
+			// every pair key is present in uniqueKeys, so the pairs starting
+			// at the first shard key belong to this shard and no other
+			aOffset := batch.addedPairs.findKey(keys[0])
+			dOffset := batch.deletedPairs.findKey(keys[0])
+			aEnd, dEnd, err := batch.integrateRange(keys, dbValues, aOffset, dOffset)
+			if err != nil {
+				return err
+			}
+			aConsumed.Add(int64(aEnd - aOffset))
+			dConsumed.Add(int64(dEnd - dOffset))
+			for i, key := range keys {
+				val := dbValues[i]
+				if len(val) == 0 {
+					dbBatch.Delete(key)
+				} else {
+					dbBatch.Put(key, val)
+				}
+			}
+			return nil
+		})
+	}
+	if err := g.Wait(); err != nil {
+		return err
+	}
+	if aConsumed.Load() != int64(len(batch.addedPairs)) || dConsumed.Load() != int64(len(batch.deletedPairs)) {
+		return fmt.Errorf("internal error: batch integration is incorrect %d != %d || %d != %d",
+			aConsumed.Load(), len(batch.addedPairs), dConsumed.Load(), len(batch.deletedPairs))
+	}
+
+	for _, dbBatch := range dbBatches {
+		if err := rdb.db.ExecuteBatch(dbBatch, rdb.writeOptions); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
 // Close closes the database and frees up resources
 func (rdb *RDB) Close() error {
 	var err error
@@ -435,6 +578,9 @@ func (rdb *RDB) Close() error {
 	if rdb.writeOptions != nil {
 		rdb.writeOptions.FreeWriteOptions()
 	}
+	if rdb.prefixReadOptions != nil {
+		rdb.prefixReadOptions.FreeReadOptions()
+	}
 	rdb.readOptions.FreeReadOptions()
 	rdb.db.CloseDatabase()
 
@@ -553,26 +699,44 @@ func (batch *Batch) getAffectedKeys() [][]byte {
 
 // integrate incorporates values in the data
 func (batch *Batch) integrate(uniqueKeys [][]byte, dbValues *[][]byte) error {
-	aOffset, dOffset := 0, 0
-	for i, key := range uniqueKeys {
+	aOffset, dOffset, err := batch.integrateRange(uniqueKeys, *dbValues, 0, 0)
+	if err != nil {
+		return err
+	}
+
+	if aOffset != len(batch.addedPairs) || dOffset != len(batch.deletedPairs) {
+		*dbValues = nil
+		return fmt.Errorf("internal error: batch integration is incorrect %d != %d || %d != %d", aOffset, len(batch.addedPairs), dOffset, len(batch.deletedPairs))
+	}
+
+	return nil
+}
+
+// integrateRange incorporates the batch pairs covering keys into dbValues,
+// starting at the given pair offsets. It returns the offsets just past the
+// consumed pairs, so contiguous key ranges can be integrated independently.
+func (batch *Batch) integrateRange(keys [][]byte, dbValues [][]byte, aOffset, dOffset int) (int, int, error) {
+	for i, key := range keys {
 		for ; aOffset < len(batch.addedPairs) && bytes.Equal(batch.addedPairs[aOffset].key, key); aOffset++ {
-			(*dbValues)[i] = appendValues((*dbValues)[i], batch.addedPairs[aOffset].values)
+			dbValues[i] = appendValues(dbValues[i], batch.addedPairs[aOffset].values)
 		}
 		for ; dOffset < len(batch.deletedPairs) && bytes.Equal(batch.deletedPairs[dOffset].key, key); dOffset++ {
 			var err error
-			(*dbValues)[i], err = delValue((*dbValues)[i], batch.deletedPairs[dOffset].values)
+			dbValues[i], err = delValue(dbValues[i], batch.deletedPairs[dOffset].values)
 			if err != nil {
-				return err
+				return aOffset, dOffset, err
 			}
 		}
 	}
 
-	if aOffset != len(batch.addedPairs) || dOffset != len(batch.deletedPairs) {
-		*dbValues = nil
-		return fmt.Errorf("internal error: batch integration is incorrect %d != %d || %d != %d", aOffset, len(batch.addedPairs), dOffset, len(batch.deletedPairs))
-	}
+	return aOffset, dOffset, nil
+}
 
-	return nil
+// merge appends the contents of other into batch
+func (batch *Batch) merge(other *Batch) {
+	batch.addedPairs = append(batch.addedPairs, other.addedPairs...)
+	batch.deletedPairs = append(batch.deletedPairs, other.deletedPairs...)
+	batch.sorted = false
 }
 
 // NewContext creates a new structure holding state across FindNext calls
@@ -585,8 +749,15 @@ func NewContext() *Context {
 }
 
 // Reset prepares the context for a new look-up cycle.
-// May be called at the start or at the end of the cycle, upon the caller's discretion
+// May be called at the start or at the end of the cycle, upon the caller's discretion.
+// It releases the value pins held by the context, so any value slices obtained
+// through it must not be used after Reset.
 func (ctx *Context) Reset() {
+	for _, slice := range ctx.pinned {
+		slice.Destroy()
+	}
+	ctx.pinned = ctx.pinned[:0]
+	clear(ctx.cache)
 }
 
 // Find returns the first data value for the given key as a byte slice.
@@ -674,6 +845,38 @@ func (rdb *RDB) FindClosest(key []byte, ctx *Context) ([]byte, []byte, error) {
 	return k, v, nil
 }
 
+// ScanPrefix calls f for every key starting with prefix, in key order.
+// The value passed to f is the raw multi-value blob - see ReadNextChunk for
+// the chunk format. Both slices are only valid for the duration of the call.
+// If f returns an error, the scan stops and the error is returned.
+func (rdb *RDB) ScanPrefix(prefix []byte, f func(key, value []byte) error) error {
+	// prefixes covered by the extractor can use a prefix-mode iterator,
+	// which skips memtables and SST files whose prefix bloom filters rule
+	// the prefix out; shorter prefixes need a total order scan
+	if rdb.prefixReadOptions != nil && rdb.prefixLen > 0 && len(prefix) >= rdb.prefixLen {
+		iter := rdb.db.CreateIterator(rdb.prefixReadOptions)
+		defer iter.FreeIterator()
+		return scanPrefix(iter, prefix, f)
+	}
+
+	iterEntry := rdb.iteratorPool.get()
+	defer func() { rdb.iteratorPool.put(iterEntry) }()
+	return scanPrefix(iterEntry.iterator, prefix, f)
+}
+
+func scanPrefix(iter *rocksdb.Iterator, prefix []byte, f func(key, value []byte) error) error {
+	for iter.Seek(prefix); iter.IsValid(); iter.Next() {
+		key := iter.Key()
+		if !bytes.HasPrefix(key, prefix) {
+			break
+		}
+		if err := f(key, iter.Value()); err != nil {
+			return err
+		}
+	}
+	return iter.GetError()
+}
+
 // ForEach calls a function for each key match.
 // The function takes a byte slice as a value and return an error.
 // if error is not nil, the loop will stop.
@@ -709,6 +912,43 @@ func (rdb *RDB) ForEach(key []byte, f func(value []byte) error, ctx *Context) (e
 	return err
 }
 
+// Prefetch resolves a set of keys in one batched multi-get and primes the
+// context cache, so subsequent Find/ForEach calls for these keys are served
+// from the context instead of paying a cgo crossing and a RocksDB seek each.
+// Keys already cached in the context are skipped.
+func (rdb *RDB) Prefetch(keys [][]byte, ctx *Context) error {
+	var missing [][]byte
+	for _, key := range keys {
+		if _, ok := ctx.cache[string(key)]; !ok {
+			missing = append(missing, key)
+		}
+	}
+	if len(missing) == 0 {
+		return nil
+	}
+
+	slices, errs := rdb.db.GetMultiPinned(rdb.readOptions, missing)
+	for _, err := range errs {
+		if err != nil {
+			for _, slice := range slices {
+				slice.Destroy()
+			}
+			return err // return the first error that had happened in GetMultiPinned()
+		}
+	}
+
+	for i, slice := range slices {
+		var data []byte
+		if slice != nil {
+			ctx.pinned = append(ctx.pinned, slice)
+			data = slice.Data()
+		}
+		ctx.update(missing[i], missing[i], data)
+	}
+
+	return nil
+}
+
 // IsV2KeySyntaxUsed returns value indicating whether v2 syntax is used for DB keys
 func (rdb *RDB) IsV2KeySyntaxUsed() bool {
 	value, err := rdb.Find([]byte(dnsdata.FeaturesKey), NewContext())
@@ -727,10 +967,16 @@ func (rdb *RDB) get(key []byte, ctx *Context) (data []byte, err error) {
 	if ok {
 		data = cachedEntry.data
 	} else {
-		data, err = rdb.db.Get(rdb.readOptions, key)
+		// pinned read: the value bytes are parsed in place and stay valid
+		// until the context releases the pin in Reset()
+		slice, err := rdb.db.GetPinned(rdb.readOptions, key)
 		if err != nil {
 			return nil, err
 		}
+		if slice != nil {
+			ctx.pinned = append(ctx.pinned, slice)
+			data = slice.Data()
+		}
 		ctx.update(key, key, data)
 	}
 
@@ -53,10 +53,12 @@ func keyOrder(a, b *dnsdata.MapRecord) int {
 // will be undefined if so).
 type Builder struct {
 	db           DBI
+	options      *rocksdb.Options
 	writeOptions *rocksdb.WriteOptions
 	values       []*dnsdata.MapRecord
 	buckets      []bucket
 	valueBuckets [][]*dnsdata.MapRecord
+	bucketLocks  []sync.Mutex // one lock per value bucket, see ScheduleAdd
 	path         string
 	useHardlinks bool
 }
@@ -76,6 +78,7 @@ func NewBuilder(path string, useHardlinks bool) (*Builder, error) {
 	options.OptimizeLevelStyleCompaction(0)
 	options.PrepareForBulkLoad()
 	options.SetFullBloomFilter(fullBloomFilterBits)
+	setPrefixExtractor(options)
 
 	db, err := rocksdb.OpenDatabase(path, false, false, options)
 	if err != nil {
@@ -88,14 +91,17 @@ func NewBuilder(path string, useHardlinks bool) (*Builder, error) {
 	)
 	return &Builder{
 		db:           db,
+		options:      options,
 		valueBuckets: make([][]*dnsdata.MapRecord, runtime.NumCPU()),
+		bucketLocks:  make([]sync.Mutex, runtime.NumCPU()),
 		writeOptions: writeOptions,
 		path:         path,
 		useHardlinks: useHardlinks,
 	}, nil
 }
 
-// FreeBuilder closes the database
+// FreeBuilder closes the database. The options passed to OpenDatabase are
+// owned and freed by CloseDatabase.
 func (b *Builder) FreeBuilder() {
 	b.writeOptions.FreeWriteOptions()
 	b.db.CloseDatabase()
@@ -105,11 +111,14 @@ func (b *Builder) FreeBuilder() {
 // we split values between NumCPU() buckets,
 // and all values with the same key will belong to the same bucket thanks to hashing.
 // Effectively, each bucket will contain a non-overlapping with other buckets set of sorted keys.
+// ScheduleAdd is safe for concurrent use: the key hash spreads callers over
+// the per-bucket locks, so contention stays low.
 func (b *Builder) ScheduleAdd(d dnsdata.MapRecord) {
 	hash := fnv1a.HashBytes32(d.Key)
 	index := int(hash % uint32(len(b.valueBuckets)))
-	bucket := b.valueBuckets[index]
-	b.valueBuckets[index] = append(bucket, &d)
+	b.bucketLocks[index].Lock()
+	b.valueBuckets[index] = append(b.valueBuckets[index], &d)
+	b.bucketLocks[index].Unlock()
 }
 
 // sort all values in binary order
@@ -221,7 +230,10 @@ func (b *Builder) saveBuckets() ([]string, error) {
 			filePath := fmt.Sprintf(templateSSTFileName, b.path, bucketNo)
 			sstFilePaths[bucketNo] = filePath
 			log.Println(writerName, "saving", len(bucketItems), "values into", filePath)
-			writer, err := rocksdb.CreateSSTFileWriter(filePath)
+			// build the file with the target DB options so it comes out with
+			// the same bloom filter and compression settings instead of the
+			// plain defaults, and ingestion does not have to rewrite it
+			writer, err := rocksdb.CreateSSTFileWriterWithOptions(filePath, b.options)
 			if err != nil {
 				return fmt.Errorf("%s: error creating writer to %s - %w", writerName, filePath, err)
 			}
@@ -15,6 +15,7 @@ package rdb
 
 import (
 	"slices"
+	"sync"
 	"testing"
 
 	"github.com/stretchr/testify/require"
@@ -179,7 +180,10 @@ func TestScheduleAdd(t *testing.T) {
 		},
 	}
 
-	b := &Builder{valueBuckets: make([][]*dnsdata.MapRecord, 3)}
+	b := &Builder{
+		valueBuckets: make([][]*dnsdata.MapRecord, 3),
+		bucketLocks:  make([]sync.Mutex, 3),
+	}
 	for _, r := range testData {
 		b.ScheduleAdd(r)
 	}
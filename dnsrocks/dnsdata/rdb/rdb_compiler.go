@@ -19,6 +19,9 @@ import (
 	"log"
 	"os"
 	"path"
+	"runtime"
+	"sync"
+	"sync/atomic"
 
 	"golang.org/x/sync/errgroup"
 
@@ -68,38 +71,58 @@ func compileBuilder(in io.Reader, codec *dnsdata.Codec, destPath string, opts Co
 	defer builder.FreeBuilder()
 
 	log.Println("Reading ...")
-	// Scan
-	counter := 0
-	nw := 0
 
-	store := func(data []dnsdata.MapRecord) {
-		for _, m := range data {
-			builder.ScheduleAdd(m)
-			nw++
-			counter++
-			if counter == DefaultBatchSize {
-				counter = 0
-				log.Println(nw)
-			}
-		}
+	consumers, err := getConsumers(opts.NumCPU)
+	if err != nil {
+		return 0, err
 	}
 
+	// Scan
+	var nw atomic.Int64
+
 	// will be closed by ParseParallelStream
 	resultsChan := make(chan []dnsdata.MapRecord, opts.NumCPU)
 
 	g.Go(func() error {
 		return dnsdata.ParseStream(in, codec, resultsChan, opts.NumCPU)
 	})
-	for v := range resultsChan {
-		store(v)
+	// Drain the parser in parallel: ScheduleAdd is safe for concurrent use,
+	// so a single consumer goroutine does not gate the parse workers.
+	var wg sync.WaitGroup
+	for i := 0; i < consumers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for v := range resultsChan {
+				for _, m := range v {
+					builder.ScheduleAdd(m)
+				}
+				n := int64(len(v))
+				if total := nw.Add(n); total/DefaultBatchSize != (total-n)/DefaultBatchSize {
+					log.Println(total)
+				}
+			}
+		}()
 	}
+	wg.Wait()
 
 	// final flush
 	if err = builder.Execute(); err != nil {
-		return nw, fmt.Errorf("building database failed: %w", err)
+		return int(nw.Load()), fmt.Errorf("building database failed: %w", err)
 	}
 
-	return nw, g.Wait()
+	return int(nw.Load()), g.Wait()
+}
+
+// getConsumers mirrors the parser worker count logic for the drain side
+func getConsumers(numCPU int) (int, error) {
+	if numCPU < 0 {
+		return 0, fmt.Errorf("bad number of workers %d", numCPU)
+	}
+	if numCPU == 0 {
+		return runtime.NumCPU(), nil
+	}
+	return numCPU, nil
 }
 
 func compileBatches(in io.Reader, codec *dnsdata.Codec, destPath string, opts CompilationOptions) (int, error) {
@@ -43,6 +43,14 @@ func (mock *mockedDB) Get(_ *rocksdb.ReadOptions, key []byte) ([]byte, error) {
 	return mock.get(key)
 }
 
+func (mock *mockedDB) GetPinned(_ *rocksdb.ReadOptions, key []byte) (*rocksdb.PinnableSlice, error) {
+	data, err := mock.get(key)
+	if err != nil || data == nil {
+		return nil, err
+	}
+	return rocksdb.PinBytes(data), nil
+}
+
 func (mock *mockedDB) Delete(_ *rocksdb.WriteOptions, key []byte) error {
 	return mock.delete(key)
 }
@@ -55,6 +63,17 @@ func (mock *mockedDB) GetMulti(readOptions *rocksdb.ReadOptions, keys [][]byte)
 	return mock.getMulti(readOptions, keys)
 }
 
+func (mock *mockedDB) GetMultiPinned(readOptions *rocksdb.ReadOptions, keys [][]byte) ([]*rocksdb.PinnableSlice, []error) {
+	values, errs := mock.getMulti(readOptions, keys)
+	slices := make([]*rocksdb.PinnableSlice, len(values))
+	for i, value := range values {
+		if value != nil {
+			slices[i] = rocksdb.PinBytes(value)
+		}
+	}
+	return slices, errs
+}
+
 func (mock *mockedDB) ExecuteBatch(_ *rocksdb.Batch, _ *rocksdb.WriteOptions) error {
 	return nil
 }
@@ -496,6 +515,40 @@ func TestRDBBatchGetAffectedKeys(t *testing.T) {
 	}
 }
 
+func TestRDBPrefetch(t *testing.T) {
+	keyA, keyB := []byte{1, 1}, []byte{2, 2}
+	valA := []byte{3, 0, 0, 0, 1, 2, 3}
+	getCalls := 0
+	rdb := &RDB{
+		db: &mockedDB{
+			get: func(_ []byte) ([]byte, error) {
+				getCalls++
+				return nil, errors.New("should be served from context")
+			},
+			getMulti: func(_ *rocksdb.ReadOptions, keys [][]byte) ([][]byte, []error) {
+				require.Equal(t, [][]byte{keyA, keyB}, keys)
+				return [][]byte{valA, nil}, make([]error, len(keys))
+			},
+		},
+	}
+	context := NewContext()
+	require.NoError(t, rdb.Prefetch([][]byte{keyA, keyB}, context))
+
+	// both keys must now resolve from the context without touching the DB
+	val, err := rdb.Find(keyA, context)
+	require.NoError(t, err)
+	require.Equal(t, []byte{1, 2, 3}, val)
+	_, err = rdb.Find(keyB, context)
+	require.Equal(t, io.EOF, err)
+	require.Equal(t, 0, getCalls)
+
+	// after Reset the pins are gone and lookups go back to the DB
+	context.Reset()
+	_, err = rdb.Find(keyA, context)
+	require.Error(t, err)
+	require.Equal(t, 1, getCalls)
+}
+
 func TestRDBContext(t *testing.T) {
 	simpleKey := []byte{5, 6, 7, 8}
 	type testCase struct {
@@ -670,6 +723,52 @@ func TestBatchGetAffectedKeys(t *testing.T) {
 	}
 }
 
+// TestBatchIntegrateRange verifies that integrating contiguous key ranges
+// with offsets obtained from findKey produces the same result as a single
+// integrate pass over all keys - this is what executeBatchSharded relies on.
+func TestBatchIntegrateRange(t *testing.T) {
+	rdb := &RDB{}
+	makeBatch := func() *Batch {
+		batch := rdb.CreateBatch()
+		batch.Add([]byte{1}, []byte("one"))
+		batch.Add([]byte{2}, []byte("two"))
+		batch.Add([]byte{2}, []byte("two-more"))
+		batch.Del([]byte{3}, []byte("three"))
+		batch.Add([]byte{4}, []byte("four"))
+		batch.sort()
+		return batch
+	}
+	makeValues := func() [][]byte {
+		return [][]byte{
+			nil,
+			appendValues(nil, []byte("existing")),
+			appendValues(nil, []byte("three")),
+			nil,
+		}
+	}
+	keys := [][]byte{{1}, {2}, {3}, {4}}
+
+	expected := makeValues()
+	err := makeBatch().integrate(keys, &expected)
+	require.NoError(t, err)
+
+	for split := 0; split <= len(keys); split++ {
+		batch := makeBatch()
+		dbValues := makeValues()
+		for _, span := range [][2]int{{0, split}, {split, len(keys)}} {
+			lo, hi := span[0], span[1]
+			if lo == hi {
+				continue
+			}
+			aOffset := batch.addedPairs.findKey(keys[lo])
+			dOffset := batch.deletedPairs.findKey(keys[lo])
+			_, _, err := batch.integrateRange(keys[lo:hi], dbValues[lo:hi], aOffset, dOffset)
+			require.NoError(t, err)
+		}
+		require.Equal(t, expected, dbValues, "split at %d", split)
+	}
+}
+
 func TestRDBFindFirst(t *testing.T) {
 	type testCase struct {
 		requestedKeys  [][]byte
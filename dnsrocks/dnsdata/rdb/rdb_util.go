@@ -51,6 +51,14 @@ func (kv *kvList) Sort() {
 	)
 }
 
+// findKey returns the offset of the first pair whose key is not less than
+// key; the list must be sorted
+func (kv kvList) findKey(key []byte) int {
+	return sort.Search(len(kv), func(i int) bool {
+		return bytes.Compare(kv[i].key, key) >= 0
+	})
+}
+
 // appendValues will append 'newVals' values to a multi-value 'data', and return the result;
 // used for add operations. It is basically a form of serialization.
 // It does so by prefixing each value with 32-bit length and concatenating the result.
@@ -0,0 +1,160 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/miekg/dns"
+
+	"github.com/facebook/dns/dnsrocks/db"
+)
+
+// answerCacheShards is the number of independently locked shards.
+// Power of two, so a shard can be selected with a mask.
+const answerCacheShards = 64
+
+// evictScanLimit bounds the number of entries inspected while looking for
+// a stale entry to evict, keeping Put O(1)
+const evictScanLimit = 8
+
+// answerCacheEntry is a single cached rendered response
+type answerCacheEntry struct {
+	generation uint64
+	expiration int64
+	response   *dns.Msg
+}
+
+type answerCacheShard struct {
+	mu      sync.RWMutex
+	entries map[string]answerCacheEntry
+}
+
+// answerCache is a sharded, TTL- and generation-aware response cache keyed
+// by (locID, qtype, qclass, qname). Each shard has its own lock, so readers
+// on different shards never contend and readers within one shard share a
+// read lock - unlike a single mutex-guarded LRU which serializes every
+// lookup. Instead of purging on DB reload the current generation is bumped:
+// entries written before the bump are treated as misses and evicted lazily,
+// so reloads do not stall queries on a full cache sweep.
+type answerCache struct {
+	generation atomic.Uint64
+	shardSize  int
+	shards     [answerCacheShards]answerCacheShard
+}
+
+// newAnswerCache creates a cache storing up to size entries overall
+func newAnswerCache(size int) *answerCache {
+	shardSize := size / answerCacheShards
+	if shardSize < 1 {
+		shardSize = 1
+	}
+	c := &answerCache{shardSize: shardSize}
+	for i := range c.shards {
+		c.shards[i].entries = make(map[string]answerCacheEntry, shardSize)
+	}
+	return c
+}
+
+// answerCacheKey renders the (location, qtype, qclass, qname) cache key
+func answerCacheKey(loc *db.Location, qtype, qclass uint16, qname string) string {
+	b := make([]byte, 0, len(loc.LocID)+4+len(qname))
+	b = append(b, loc.LocID...)
+	b = append(b, byte(qtype>>8), byte(qtype), byte(qclass>>8), byte(qclass))
+	b = append(b, qname...)
+	return string(b)
+}
+
+// shardFor picks the shard for the key using FNV-1a
+func (c *answerCache) shardFor(key string) *answerCacheShard {
+	const offset64, prime64 = uint64(14695981039346656037), uint64(1099511628211)
+	h := offset64
+	for i := 0; i < len(key); i++ {
+		h ^= uint64(key[i])
+		h *= prime64
+	}
+	return &c.shards[h&(answerCacheShards-1)]
+}
+
+// Get returns the cached response for the key, if any. The returned message
+// is shared - callers must Copy it before modifying. expired reports that an
+// entry existed but was past its deadline (the entry is dropped).
+func (c *answerCache) Get(key string) (response *dns.Msg, expired bool) {
+	generation := c.generation.Load()
+	shard := c.shardFor(key)
+	shard.mu.RLock()
+	entry, ok := shard.entries[key]
+	shard.mu.RUnlock()
+	if !ok || entry.generation != generation {
+		return nil, false
+	}
+	if entry.expiration < time.Now().Unix() {
+		shard.mu.Lock()
+		// recheck: the entry may have been replaced since the read lock was dropped
+		if e, ok := shard.entries[key]; ok && e.expiration == entry.expiration {
+			delete(shard.entries, key)
+		}
+		shard.mu.Unlock()
+		return nil, true
+	}
+	return entry.response, false
+}
+
+// Put stores the response under the key until the expiration timestamp
+// (unix seconds) or the next generation bump, whichever comes first
+func (c *answerCache) Put(key string, response *dns.Msg, expiration int64) {
+	generation := c.generation.Load()
+	shard := c.shardFor(key)
+	shard.mu.Lock()
+	if len(shard.entries) >= c.shardSize {
+		shard.evictLocked(generation, time.Now().Unix())
+	}
+	shard.entries[key] = answerCacheEntry{
+		generation: generation,
+		expiration: expiration,
+		response:   response,
+	}
+	shard.mu.Unlock()
+}
+
+// BumpGeneration invalidates all current entries in O(1): they become
+// misses immediately and are reclaimed lazily by evictLocked
+func (c *answerCache) BumpGeneration() {
+	c.generation.Add(1)
+}
+
+// evictLocked frees one slot: it prefers a stale (old generation or expired)
+// entry among the first few seen, falling back to an arbitrary one. Go map
+// iteration order is randomized, which makes this an effective low-cost
+// eviction policy for a cache dominated by a small hot set.
+func (s *answerCacheShard) evictLocked(generation uint64, now int64) {
+	var fallback string
+	scanned := 0
+	for k, e := range s.entries {
+		if e.generation != generation || e.expiration < now {
+			delete(s.entries, k)
+			return
+		}
+		if scanned == 0 {
+			fallback = k
+		}
+		scanned++
+		if scanned >= evictScanLimit {
+			break
+		}
+	}
+	delete(s.entries, fallback)
+}
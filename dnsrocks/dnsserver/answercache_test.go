@@ -0,0 +1,107 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"fmt"
+	"testing"
+	"time"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+
+	"github.com/facebook/dns/dnsrocks/db"
+)
+
+func testAnswerMsg(name string) *dns.Msg {
+	m := new(dns.Msg)
+	m.SetQuestion(dns.Fqdn(name), dns.TypeA)
+	return m
+}
+
+func TestAnswerCacheHitMissExpiry(t *testing.T) {
+	c := newAnswerCache(1024)
+	loc := &db.Location{LocID: []byte{0, 1}}
+	key := answerCacheKey(loc, dns.TypeA, dns.ClassINET, "www.example.com.")
+
+	// miss on empty cache
+	resp, expired := c.Get(key)
+	require.Nil(t, resp)
+	require.False(t, expired)
+
+	// hit after Put
+	msg := testAnswerMsg("www.example.com.")
+	c.Put(key, msg, time.Now().Unix()+1000)
+	resp, expired = c.Get(key)
+	require.Equal(t, msg, resp)
+	require.False(t, expired)
+
+	// expired entry is reported as such and dropped
+	c.Put(key, msg, time.Now().Unix()-1)
+	resp, expired = c.Get(key)
+	require.Nil(t, resp)
+	require.True(t, expired)
+	// second read is a plain miss
+	resp, expired = c.Get(key)
+	require.Nil(t, resp)
+	require.False(t, expired)
+}
+
+func TestAnswerCacheGenerationInvalidation(t *testing.T) {
+	c := newAnswerCache(1024)
+	loc := &db.Location{LocID: []byte{0, 1}}
+	key := answerCacheKey(loc, dns.TypeA, dns.ClassINET, "www.example.com.")
+
+	c.Put(key, testAnswerMsg("www.example.com."), time.Now().Unix()+1000)
+	resp, _ := c.Get(key)
+	require.NotNil(t, resp)
+
+	// entries written before the bump become misses
+	c.BumpGeneration()
+	resp, expired := c.Get(key)
+	require.Nil(t, resp)
+	require.False(t, expired)
+
+	// entries written after the bump are served again
+	c.Put(key, testAnswerMsg("www.example.com."), time.Now().Unix()+1000)
+	resp, _ = c.Get(key)
+	require.NotNil(t, resp)
+}
+
+func TestAnswerCacheKeyUniqueness(t *testing.T) {
+	locA := &db.Location{LocID: []byte{0, 1}}
+	locB := &db.Location{LocID: []byte{0, 2}}
+	keys := map[string]bool{
+		answerCacheKey(locA, dns.TypeA, dns.ClassINET, "www.example.com."):    true,
+		answerCacheKey(locB, dns.TypeA, dns.ClassINET, "www.example.com."):    true,
+		answerCacheKey(locA, dns.TypeAAAA, dns.ClassINET, "www.example.com."): true,
+		answerCacheKey(locA, dns.TypeA, dns.ClassINET, "www2.example.com."):   true,
+	}
+	require.Equal(t, 4, len(keys))
+}
+
+func TestAnswerCacheEviction(t *testing.T) {
+	// a cache this small has one slot per shard
+	c := newAnswerCache(answerCacheShards)
+	loc := &db.Location{LocID: []byte{0, 1}}
+	for i := 0; i < 10*answerCacheShards; i++ {
+		key := answerCacheKey(loc, dns.TypeA, dns.ClassINET, fmt.Sprintf("host%d.example.com.", i))
+		c.Put(key, testAnswerMsg("www.example.com."), time.Now().Unix()+1000)
+	}
+	total := 0
+	for i := range c.shards {
+		total += len(c.shards[i].entries)
+	}
+	require.LessOrEqual(t, total, answerCacheShards)
+}
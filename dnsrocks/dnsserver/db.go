@@ -26,7 +26,6 @@ import (
 	"github.com/coredns/coredns/plugin"
 	"github.com/fsnotify/fsnotify"
 	"github.com/golang/glog"
-	lru "github.com/hashicorp/golang-lru"
 
 	"github.com/facebook/dns/dnsrocks/db"
 	"github.com/facebook/dns/dnsrocks/dnsserver/stats"
@@ -48,6 +47,14 @@ type DBConfig struct {
 	ReloadTimeout  time.Duration
 	WatchDB        bool
 	ValidationKey  []byte
+	// WarmupMaxQueries > 0 enables post-reload warming: up to that many
+	// recently seen queries are tracked and replayed against a freshly
+	// reloaded DB before it starts taking traffic, so cutover does not
+	// happen on a cold block cache.
+	WarmupMaxQueries int
+	// WarmupTimeout bounds how long cutover waits for the warmup replay;
+	// zero means a small built-in default.
+	WarmupTimeout time.Duration
 }
 
 // ReloadType - how to reload the DB
@@ -103,7 +110,8 @@ type FBDNSDB struct {
 	cacheConfig   CacheConfig
 	reloadMu      sync.RWMutex
 	done          chan struct{}
-	lru           *lru.Cache
+	cache         *answerCache
+	hotQueries    *hotQueryTracker
 	logger        Logger
 	stats         stats.Stats
 	Next          plugin.Handler
@@ -111,18 +119,22 @@ type FBDNSDB struct {
 
 // NewFBDNSDBBasic initialize a new FBDNSDB. Reloading strategy is left to be set.
 func NewFBDNSDBBasic(handlerConfig HandlerConfig, dbConfig DBConfig, cacheConfig CacheConfig, l Logger, s stats.Stats) (t *FBDNSDB, err error) {
-	var lrucache *lru.Cache
+	var cache *answerCache
 	if cacheConfig.Enabled {
-		if lrucache, err = lru.New(cacheConfig.LRUSize); err != nil {
-			return
-		}
+		cache = newAnswerCache(cacheConfig.LRUSize)
+	}
+
+	var hotQueries *hotQueryTracker
+	if dbConfig.WarmupMaxQueries > 0 {
+		hotQueries = newHotQueryTracker(dbConfig.WarmupMaxQueries)
 	}
 
 	tdb := &FBDNSDB{
 		handlerConfig: handlerConfig,
 		dbConfig:      dbConfig,
 		cacheConfig:   cacheConfig,
-		lru:           lrucache,
+		cache:         cache,
+		hotQueries:    hotQueries,
 		logger:        l,
 		stats:         s,
 		done:          make(chan struct{}),
@@ -356,12 +368,25 @@ func (h *FBDNSDB) Reload(s ReloadSignal) (err error) {
 		return
 	}
 
+	// Warm the fresh DB with the recent hot queries before it takes
+	// traffic, bounded by the warmup deadline. newDB is not published yet,
+	// so the write lock is released while it is walked: the current DB
+	// keeps serving queries in the meantime. Reloads themselves stay
+	// serialized by the ReloadChan consumer goroutine. A catch-up reload
+	// keeps the same DB (and block cache), so there is nothing to warm.
+	if h.hotQueries != nil && newDB != h.dnsdb {
+		h.reloadMu.Unlock()
+		h.warmDB(newDB)
+		h.reloadMu.Lock()
+	}
+
 	// if we didn't timeout and reloading finished without errors
 	h.dnsdb = newDB
 	h.dbConfig.Path = newPath
 
-	if h.cacheConfig.Enabled && h.lru != nil {
-		h.lru.Purge()
+	if h.cacheConfig.Enabled && h.cache != nil {
+		// invalidate all cached answers in O(1) instead of sweeping the cache
+		h.cache.BumpGeneration()
 	}
 
 	if err := h.cleanupSignalFile(s); err != nil {
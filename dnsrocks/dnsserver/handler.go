@@ -40,11 +40,6 @@ const (
 
 var typeToStats = make(map[uint16]string)
 
-type cacheEntry struct {
-	expiration int64
-	response   *dns.Msg
-}
-
 type maxAnswerKey string
 
 // WithMaxAnswer set max ans in context
@@ -106,7 +101,18 @@ func (h *FBDNSDB) writeAndLog(state request.Request, resp *dns.Msg, ecs *dns.EDN
 	rcode := resp.Rcode
 
 	state.SizeAndDo(resp)
-	state.Scrub(resp)
+	if msgSizeUpperBound(resp) > state.Size() {
+		// Scrub simulates a full compressed pack to decide on truncation;
+		// only pay for it when the cheap upper bound says the response
+		// might not fit. Fitting responses go straight to the single real
+		// pack in WriteMsg.
+		state.Scrub(resp)
+	} else {
+		// the bound credits owner-name compression, so skipping Scrub is
+		// only valid if the real pack compresses too; Scrub would have set
+		// this itself for a message that only fits compressed
+		resp.Compress = true
+	}
 
 	if h.handlerConfig.AlwaysCompress {
 		// Compression should be set AFTER potential Truncate call inside Scrub
@@ -144,8 +150,9 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 		// EDNS Client subnet option
 		ecs *dns.EDNS0_SUBNET
 		o   *dns.OPT
-		// packed lowercased version of the qname
-		packedQName = make([]byte, 255)
+		// scratch buffer holding the packed lowercased version of the qname
+		qnameBuf    = acquireQNameBuf()
+		packedQName = *qnameBuf
 		zoneCut     []byte
 		// Used to track if the answer was using Weighted Random Sample or not. When
 		// using WRS, we should not cache it.
@@ -154,6 +161,11 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 		cacheKey string
 	)
 	h.stats.IncrementCounter("DNS_queries")
+	// per-stage timing for this query; nil (a no-op) unless sampled
+	stages := newStageTimer(h.stats)
+	// zoneCut and the location lookups may alias the buffer, so it is only
+	// returned to the pool once the request is fully handled.
+	defer releaseQNameBuf(qnameBuf)
 
 	reader, err := h.AcquireReader()
 	if err != nil {
@@ -191,7 +203,9 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 
 	packedQName = packedQName[:offset]
 
-	if ecs, loc, err = reader.FindLocation(packedQName, r, state.IP()); err != nil {
+	ecs, loc, err = reader.FindLocation(packedQName, r, state.IP())
+	stages.mark(stageFindLocationKey)
+	if err != nil {
 		glog.Errorf("%s: failed to find location: %v", state.Name(), err)
 		//dns.HandleFailed(w, r)
 		h.logger.LogFailed(state, r, ecs)
@@ -218,41 +232,44 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 		h.stats.IncrementCounter("DNS_location.resolver")
 	}
 
+	if h.hotQueries != nil {
+		// feed the post-reload warmup; sampled, so effectively free here
+		h.hotQueries.record(packedQName, state.Name(), state.QType(), loc)
+	}
+
 	if h.cacheConfig.Enabled {
-		cacheKey = fmt.Sprintf("%.3d%.3d%.3d%s", loc.LocID, state.QType(), state.QClass(), state.Name())
-		if v, ok := h.lru.Get(cacheKey); ok {
-			t := v.(cacheEntry).expiration
-			if t < time.Now().Unix() {
-				// evict answer
-				h.stats.IncrementCounter("DNS_cache.expired")
-				h.lru.Remove(cacheKey)
-			} else {
-				h.stats.IncrementCounter("DNS_cache.hit")
-				resp := v.(cacheEntry).response.Copy()
-				// SetReply sets rcode to RcodeSuccess...
-				rcode := resp.Rcode
-				resp.SetReply(r)
-				resp.Rcode = rcode
-				if r.IsEdns0() != nil {
-					o = new(dns.OPT)
-					o.Hdr.Name = "."
-					o.Hdr.Rrtype = dns.TypeOPT
-
-					if ecs != nil {
-						o.Option = append(o.Option, ecs)
-					}
-
-					resp.Extra = append([]dns.RR{o}, resp.Extra...)
+		cacheKey = answerCacheKey(loc, state.QType(), state.QClass(), state.Name())
+		if cached, expired := h.cache.Get(cacheKey); cached != nil {
+			h.stats.IncrementCounter("DNS_cache.hit")
+			resp := cached.Copy()
+			// SetReply sets rcode to RcodeSuccess...
+			rcode := resp.Rcode
+			resp.SetReply(r)
+			resp.Rcode = rcode
+			if r.IsEdns0() != nil {
+				o = new(dns.OPT)
+				o.Hdr.Name = "."
+				o.Hdr.Rrtype = dns.TypeOPT
+
+				if ecs != nil {
+					o.Option = append(o.Option, ecs)
 				}
-				return h.writeAndLog(state, resp, ecs)
+
+				resp.Extra = append([]dns.RR{o}, resp.Extra...)
 			}
+			return h.writeAndLog(state, resp, ecs)
+		} else if expired {
+			h.stats.IncrementCounter("DNS_cache.expired")
 		} else {
 			h.stats.IncrementCounter("DNS_cache.missed")
 		}
 	}
 
-	// Set default answer payload
-	a := new(dns.Msg)
+	// Set default answer payload. The message comes from the response pool
+	// and goes back to it once it has been written and logged; nothing below
+	// may retain a reference into it (the cache stores a copy).
+	a := acquireMsg()
+	defer releaseMsg(a)
 	a.SetReply(r)
 	a.Compress = true
 	a.Authoritative = true
@@ -261,6 +278,7 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 	// its name servers. The domain returned is the one for which we found
 	// matching SOA or NS
 	ns, auth, zoneCut, err := reader.IsAuthoritative(packedQName, loc)
+	stages.mark(stageIsAuthoritativeKey)
 
 	if err != nil {
 		h.stats.IncrementCounter("DNS_error.is_authoritative")
@@ -270,7 +288,8 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 
 	if !ns && !auth {
 		h.stats.IncrementCounter("DNS_response.refused")
-		m := new(dns.Msg)
+		m := acquireMsg()
+		defer releaseMsg(m)
 		m.SetRcode(r, dns.RcodeRefused)
 		// We can use Extended DNS Errors to indicate that the server is not authoritative for certain Query
 		// instead of just returning a REFUSED
@@ -315,6 +334,7 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 			// log something
 		}
 		weighted, recordFound = reader.FindAnswer(packedQName, zoneCut, state.QName(), state.QType(), loc, a, maxAns)
+		stages.mark(stageFindAnswerKey)
 		if len(a.Answer) == 0 && !recordFound {
 			a.Rcode = dns.RcodeNameError
 		}
@@ -353,12 +373,12 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 		// Cache answer before we add ECS/options
 		var timeout int64
 		if !weighted {
-			// FIXME: we can leave this in cache until it get flushed (via DB reload)
+			// entries survive DB reloads via the cache generation bump
 			timeout = time.Now().Unix() + 1000
-			h.lru.Add(cacheKey, cacheEntry{expiration: timeout, response: a.Copy()})
+			h.cache.Put(cacheKey, a.Copy(), timeout)
 		} else if h.cacheConfig.WRSTimeout > 0 {
 			timeout = time.Now().Unix() + h.cacheConfig.WRSTimeout
-			h.lru.Add(cacheKey, cacheEntry{expiration: timeout, response: a.Copy()})
+			h.cache.Put(cacheKey, a.Copy(), timeout)
 		}
 	}
 
@@ -374,7 +394,9 @@ func (h *FBDNSDB) ServeDNSWithRCODE(ctx context.Context, w dns.ResponseWriter, r
 		a.Extra = append([]dns.RR{o}, a.Extra...)
 	}
 
-	return h.writeAndLog(state, a, ecs)
+	rcode, err := h.writeAndLog(state, a, ecs)
+	stages.mark(stageWriteAndLogKey)
+	return rcode, err
 }
 
 // ServeDNS implements the plugin.Handler interface.
@@ -395,6 +417,18 @@ func rrTypeToUnit(qType string) (uint16, error) {
 	return 0, fmt.Errorf("unknown QTYPE %s", qType)
 }
 
+// copyingWriter wraps the recorder QuerySingle hands to ServeDNSWithRCODE.
+// The handler releases its pooled response message back to the pool as soon
+// as the write returns, but dnstest.Recorder keeps the pointer around for
+// the caller, so the message is deep-copied before it is recorded.
+type copyingWriter struct {
+	*dnstest.Recorder
+}
+
+func (w copyingWriter) WriteMsg(m *dns.Msg) error {
+	return w.Recorder.WriteMsg(m.Copy())
+}
+
 // QuerySingle queries dns server for a query, returning single answer if possible
 func (h *FBDNSDB) QuerySingle(rtype, record, remoteIP, subnet string, maxAns int) (*dnstest.Recorder, error) {
 	req := new(dns.Msg)
@@ -415,7 +449,7 @@ func (h *FBDNSDB) QuerySingle(rtype, record, remoteIP, subnet string, maxAns int
 	ctx = WithMaxAnswer(ctx, maxAns)
 
 	rec := dnstest.NewRecorder(&test.ResponseWriterCustomRemote{RemoteIP: remoteIP})
-	_, err = h.ServeDNSWithRCODE(ctx, rec, req)
+	_, err = h.ServeDNSWithRCODE(ctx, copyingWriter{rec}, req)
 	if err != nil {
 		return nil, err
 	}
@@ -0,0 +1,71 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"sync"
+
+	"github.com/miekg/dns"
+)
+
+// msgPool recycles response messages between queries. Reusing a message keeps
+// the backing arrays of its record sections, so once the pool is warm a query
+// no longer allocates for the message itself nor for growing Answer/Ns/Extra.
+//
+// A message may only be released after the response has been written and
+// logged: both the in-tree ResponseWriters and the loggers pack the message
+// synchronously and do not retain it afterwards.
+var msgPool = sync.Pool{
+	New: func() interface{} { return new(dns.Msg) },
+}
+
+// acquireMsg returns an empty message from the pool.
+func acquireMsg() *dns.Msg {
+	return msgPool.Get().(*dns.Msg)
+}
+
+// releaseMsg resets m while keeping the section backing arrays and returns it
+// to the pool. The caller must not keep references into m afterwards.
+func releaseMsg(m *dns.Msg) {
+	m.MsgHdr = dns.MsgHdr{}
+	m.Compress = false
+	clear(m.Question)
+	m.Question = m.Question[:0]
+	clear(m.Answer)
+	m.Answer = m.Answer[:0]
+	clear(m.Ns)
+	m.Ns = m.Ns[:0]
+	clear(m.Extra)
+	m.Extra = m.Extra[:0]
+	msgPool.Put(m)
+}
+
+// qnameBufPool recycles the fixed-size buffers used to pack the query name.
+var qnameBufPool = sync.Pool{
+	New: func() interface{} {
+		b := make([]byte, 255)
+		return &b
+	},
+}
+
+// acquireQNameBuf returns a 255 byte scratch buffer for dns.PackDomainName.
+func acquireQNameBuf() *[]byte {
+	return qnameBufPool.Get().(*[]byte)
+}
+
+// releaseQNameBuf returns a buffer obtained from acquireQNameBuf to the pool.
+func releaseQNameBuf(b *[]byte) {
+	*b = (*b)[:255]
+	qnameBufPool.Put(b)
+}
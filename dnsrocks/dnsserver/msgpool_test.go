@@ -0,0 +1,57 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"testing"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+)
+
+// TestMsgPoolRelease checks that a released message comes back empty while
+// keeping the capacity of its record sections.
+func TestMsgPoolRelease(t *testing.T) {
+	m := acquireMsg()
+	req := new(dns.Msg)
+	req.SetQuestion("example.com.", dns.TypeA)
+	m.SetReply(req)
+	m.Compress = true
+	m.Answer = append(m.Answer, &dns.A{Hdr: dns.RR_Header{Name: "example.com.", Rrtype: dns.TypeA, Class: dns.ClassINET}})
+	m.Ns = append(m.Ns, &dns.NS{Hdr: dns.RR_Header{Name: "example.com.", Rrtype: dns.TypeNS, Class: dns.ClassINET}})
+	m.Extra = append(m.Extra, &dns.OPT{Hdr: dns.RR_Header{Name: ".", Rrtype: dns.TypeOPT}})
+	answerCap := cap(m.Answer)
+
+	releaseMsg(m)
+
+	require.Equal(t, dns.MsgHdr{}, m.MsgHdr)
+	require.False(t, m.Compress)
+	require.Empty(t, m.Question)
+	require.Empty(t, m.Answer)
+	require.Empty(t, m.Ns)
+	require.Empty(t, m.Extra)
+	require.Equal(t, answerCap, cap(m.Answer))
+}
+
+// TestQNameBufPool checks that buffers come back at full length after having
+// been truncated by the packing code.
+func TestQNameBufPool(t *testing.T) {
+	buf := acquireQNameBuf()
+	require.Len(t, *buf, 255)
+	*buf = (*buf)[:12]
+	releaseQNameBuf(buf)
+	buf = acquireQNameBuf()
+	require.Len(t, *buf, 255)
+	releaseQNameBuf(buf)
+}
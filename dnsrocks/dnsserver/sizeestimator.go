@@ -0,0 +1,88 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"strings"
+	"sync"
+
+	"github.com/miekg/dns"
+)
+
+// compressionPointerLen is the wire size of a DNS name compression pointer
+const compressionPointerLen = 2
+
+// dnsHeaderLen is the fixed size of the DNS message header
+const dnsHeaderLen = 12
+
+// seenNamesPool recycles the owner-name sets used by msgSizeUpperBound so
+// the fit check does not allocate per response.
+var seenNamesPool = sync.Pool{
+	New: func() interface{} { return make(map[string]struct{}, 8) },
+}
+
+// nameWireLen returns the packed size of a domain name in text form, or
+// -1 when it cannot be derived without packing (escaped names). For a
+// plain fqdn the wire form is one byte per character plus the root label.
+func nameWireLen(name string) int {
+	if strings.ContainsRune(name, '\\') {
+		return -1
+	}
+	if name == "." {
+		return 1
+	}
+	return len(name) + 1
+}
+
+// msgSizeUpperBound returns a conservative upper bound on the packed,
+// compressed size of resp in a single cheap walk: every record is counted
+// at its uncompressed length, except that repeated owner names - the common
+// case for large RRsets - are counted as a compression pointer. The real
+// packer compresses at least that much (it also compresses rdata names and
+// suffixes), so the bound never under-estimates: a response whose bound
+// fits the advertised size needs no truncation pass before packing.
+func msgSizeUpperBound(resp *dns.Msg) int {
+	seen := seenNamesPool.Get().(map[string]struct{})
+	defer func() {
+		clear(seen)
+		seenNamesPool.Put(seen)
+	}()
+
+	size := dnsHeaderLen
+	for _, q := range resp.Question {
+		// owner names can point at the question name
+		if wire := nameWireLen(q.Name); wire > 0 {
+			seen[q.Name] = struct{}{}
+		}
+		size += len(q.Name) + 1 + 4
+	}
+	for _, section := range [][]dns.RR{resp.Answer, resp.Ns, resp.Extra} {
+		for _, rr := range section {
+			size += dns.Len(rr)
+			name := rr.Header().Name
+			wire := nameWireLen(name)
+			if wire < 0 {
+				// escaped name: count it uncompressed rather than risk
+				// under-estimating
+				continue
+			}
+			if _, ok := seen[name]; ok {
+				size += compressionPointerLen - wire
+			} else {
+				seen[name] = struct{}{}
+			}
+		}
+	}
+	return size
+}
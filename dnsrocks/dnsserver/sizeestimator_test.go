@@ -0,0 +1,128 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"fmt"
+	"net"
+	"testing"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+)
+
+// packedLen packs the message with compression on and returns the wire size
+func packedLen(t *testing.T, m *dns.Msg) int {
+	t.Helper()
+	m.Compress = true
+	packed, err := m.Pack()
+	require.NoError(t, err)
+	return len(packed)
+}
+
+func TestMsgSizeUpperBoundNeverUnderestimates(t *testing.T) {
+	testCases := []struct {
+		name  string
+		build func() *dns.Msg
+	}{
+		{
+			name: "large same-owner rrset",
+			build: func() *dns.Msg {
+				m := new(dns.Msg)
+				m.SetQuestion("lb.example.com.", dns.TypeA)
+				for i := 0; i < 50; i++ {
+					m.Answer = append(m.Answer, &dns.A{
+						Hdr: dns.RR_Header{Name: "lb.example.com.", Rrtype: dns.TypeA, Class: dns.ClassINET, Ttl: 300},
+						A:   net.IPv4(10, 0, byte(i>>8), byte(i)),
+					})
+				}
+				return m
+			},
+		},
+		{
+			name: "mixed sections with opt",
+			build: func() *dns.Msg {
+				m := new(dns.Msg)
+				m.SetQuestion("www.example.com.", dns.TypeAAAA)
+				m.Answer = append(m.Answer, &dns.CNAME{
+					Hdr:    dns.RR_Header{Name: "www.example.com.", Rrtype: dns.TypeCNAME, Class: dns.ClassINET, Ttl: 300},
+					Target: "lb.example.com.",
+				})
+				m.Ns = append(m.Ns, &dns.NS{
+					Hdr: dns.RR_Header{Name: "example.com.", Rrtype: dns.TypeNS, Class: dns.ClassINET, Ttl: 300},
+					Ns:  "ns1.example.com.",
+				})
+				m.SetEdns0(4096, true)
+				return m
+			},
+		},
+		{
+			name: "escaped owner name",
+			build: func() *dns.Msg {
+				m := new(dns.Msg)
+				m.SetQuestion(`weird\.label.example.com.`, dns.TypeTXT)
+				m.Answer = append(m.Answer, &dns.TXT{
+					Hdr: dns.RR_Header{Name: `weird\.label.example.com.`, Rrtype: dns.TypeTXT, Class: dns.ClassINET, Ttl: 300},
+					Txt: []string{"hello"},
+				})
+				return m
+			},
+		},
+		{
+			name: "root owner",
+			build: func() *dns.Msg {
+				m := new(dns.Msg)
+				m.SetQuestion(".", dns.TypeNS)
+				m.Ns = append(m.Ns, &dns.SOA{
+					Hdr: dns.RR_Header{Name: ".", Rrtype: dns.TypeSOA, Class: dns.ClassINET, Ttl: 300},
+					Ns:  "a.root-servers.net.", Mbox: "nstld.verisign-grs.com.",
+					Serial: 1, Refresh: 1800, Retry: 900, Expire: 604800, Minttl: 86400,
+				})
+				return m
+			},
+		},
+	}
+
+	for _, tc := range testCases {
+		t.Run(tc.name, func(t *testing.T) {
+			m := tc.build()
+			bound := msgSizeUpperBound(m)
+			actual := packedLen(t, m)
+			require.GreaterOrEqual(t, bound, actual,
+				fmt.Sprintf("bound %d must cover packed size %d", bound, actual))
+		})
+	}
+}
+
+func TestMsgSizeUpperBoundIsTight(t *testing.T) {
+	// For a repeated-owner RRset the bound should be close to the real
+	// packed size, otherwise the fit check degenerates to always scrubbing.
+	m := new(dns.Msg)
+	m.SetQuestion("lb.example.com.", dns.TypeA)
+	for i := 0; i < 20; i++ {
+		m.Answer = append(m.Answer, &dns.A{
+			Hdr: dns.RR_Header{Name: "lb.example.com.", Rrtype: dns.TypeA, Class: dns.ClassINET, Ttl: 300},
+			A:   net.IPv4(10, 0, 0, byte(i)),
+		})
+	}
+	bound := msgSizeUpperBound(m)
+	actual := packedLen(t, m)
+	require.LessOrEqual(t, bound, actual+actual/10, "bound should stay within ~10%% of the packed size")
+}
+
+func TestNameWireLen(t *testing.T) {
+	require.Equal(t, 1, nameWireLen("."))
+	require.Equal(t, 13, nameWireLen("example.com."))
+	require.Equal(t, -1, nameWireLen(`esc\.aped.com.`))
+}
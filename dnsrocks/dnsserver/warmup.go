@@ -0,0 +1,148 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"container/list"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/golang/glog"
+	"github.com/miekg/dns"
+
+	"github.com/facebook/dns/dnsrocks/db"
+)
+
+// hotQuerySampleRate is how many queries pass between two recordings. The
+// tracker only needs a sketch of what is hot, so it stays off the hot path
+// for all but one query in hotQuerySampleRate.
+const hotQuerySampleRate = 64
+
+// defaultWarmupTimeout bounds the post-reload warmup stage when
+// DBConfig.WarmupTimeout is left unset.
+const defaultWarmupTimeout = 5 * time.Second
+
+// hotQuery is one recorded (qname, qtype, location) triple, everything
+// needed to replay the query against a fresh DB.
+type hotQuery struct {
+	packedQName []byte
+	qname       string
+	qtype       uint16
+	loc         db.Location
+}
+
+// hotQueryTracker keeps the most recently seen distinct queries, sampled, in
+// LRU order. It feeds the post-reload warmup stage: replaying its content
+// against a freshly opened DB faults the hot part of the block cache in
+// before the new DB takes traffic.
+type hotQueryTracker struct {
+	counter atomic.Uint64
+	max     int
+
+	mu      sync.Mutex
+	order   *list.List // front is most recent, values are *hotQuery
+	entries map[string]*list.Element
+}
+
+func newHotQueryTracker(max int) *hotQueryTracker {
+	return &hotQueryTracker{
+		max:     max,
+		order:   list.New(),
+		entries: make(map[string]*list.Element, max),
+	}
+}
+
+// record notes a query. All arguments may alias per-request scratch buffers:
+// they are copied if (and only if) this query is sampled.
+func (t *hotQueryTracker) record(packedQName []byte, qname string, qtype uint16, loc *db.Location) {
+	if t.counter.Add(1)%hotQuerySampleRate != 0 {
+		return
+	}
+	key := answerCacheKey(loc, qtype, dns.ClassINET, qname)
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	if el, ok := t.entries[key]; ok {
+		t.order.MoveToFront(el)
+		return
+	}
+	q := &hotQuery{
+		packedQName: append([]byte(nil), packedQName...),
+		qname:       qname,
+		qtype:       qtype,
+		loc: db.Location{
+			MapID: append([]byte(nil), loc.MapID...),
+			Mask:  loc.Mask,
+			LocID: append([]byte(nil), loc.LocID...),
+		},
+	}
+	t.entries[key] = t.order.PushFront(q)
+	if t.order.Len() > t.max {
+		oldest := t.order.Back()
+		t.order.Remove(oldest)
+		delete(t.entries, answerCacheKey(&oldest.Value.(*hotQuery).loc,
+			oldest.Value.(*hotQuery).qtype, dns.ClassINET, oldest.Value.(*hotQuery).qname))
+	}
+}
+
+// snapshot returns the tracked queries, most recent first
+func (t *hotQueryTracker) snapshot() []*hotQuery {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	queries := make([]*hotQuery, 0, t.order.Len())
+	for el := t.order.Front(); el != nil; el = el.Next() {
+		queries = append(queries, el.Value.(*hotQuery))
+	}
+	return queries
+}
+
+// warmDB replays the tracked hot queries against newDB, bounded by the
+// configured deadline. It runs before the new DB is swapped in: the old DB
+// keeps serving while this walks the new one, so the block cache is no
+// longer cold when cutover happens.
+func (h *FBDNSDB) warmDB(newDB *db.DB) {
+	queries := h.hotQueries.snapshot()
+	if len(queries) == 0 {
+		return
+	}
+	timeout := h.dbConfig.WarmupTimeout
+	if timeout <= 0 {
+		timeout = defaultWarmupTimeout
+	}
+	reader, err := db.NewReader(newDB)
+	if err != nil {
+		glog.Errorf("Failed to acquire reader for DB warmup: %v", err)
+		return
+	}
+	defer reader.Close()
+
+	start := time.Now()
+	a := new(dns.Msg)
+	replayed := 0
+	for _, q := range queries {
+		if time.Since(start) > timeout {
+			glog.Infof("DB warmup hit the %v deadline after %d queries", timeout, replayed)
+			break
+		}
+		ns, auth, zoneCut, err := reader.IsAuthoritative(q.packedQName, &q.loc)
+		if err != nil || (!ns && !auth) {
+			continue
+		}
+		a.Answer, a.Ns, a.Extra = a.Answer[:0], a.Ns[:0], a.Extra[:0]
+		reader.FindAnswer(q.packedQName, zoneCut, q.qname, q.qtype, &q.loc, a, DefaultMaxAnswer)
+		replayed++
+	}
+	h.stats.IncrementCounterBy("DNS_db.warmup_queries", int64(replayed))
+	glog.Infof("Warmed up new DB with %d/%d hot queries in %v", replayed, len(queries), time.Since(start))
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package dnsserver
+
+import (
+	"testing"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+
+	"github.com/facebook/dns/dnsrocks/db"
+)
+
+// recordSampled drives record past the sampling gate so the query is
+// guaranteed to have been seen at least once.
+func recordSampled(t *hotQueryTracker, qname string, qtype uint16) {
+	packed := make([]byte, 255)
+	offset, _ := dns.PackDomainName(qname, packed, 0, nil, false)
+	loc := &db.Location{MapID: []byte{0, 0}, LocID: []byte{0, 0}}
+	for i := 0; i < hotQuerySampleRate; i++ {
+		t.record(packed[:offset], qname, qtype, loc)
+	}
+}
+
+func TestHotQueryTrackerKeepsMostRecent(t *testing.T) {
+	tracker := newHotQueryTracker(2)
+	recordSampled(tracker, "a.example.com.", dns.TypeA)
+	recordSampled(tracker, "b.example.com.", dns.TypeA)
+	recordSampled(tracker, "c.example.com.", dns.TypeAAAA)
+
+	queries := tracker.snapshot()
+	require.Len(t, queries, 2)
+	// most recent first, oldest evicted
+	require.Equal(t, "c.example.com.", queries[0].qname)
+	require.Equal(t, dns.TypeAAAA, queries[0].qtype)
+	require.Equal(t, "b.example.com.", queries[1].qname)
+}
+
+func TestHotQueryTrackerMovesRecordedToFront(t *testing.T) {
+	tracker := newHotQueryTracker(2)
+	recordSampled(tracker, "a.example.com.", dns.TypeA)
+	recordSampled(tracker, "b.example.com.", dns.TypeA)
+	// re-recording must refresh, not duplicate
+	recordSampled(tracker, "a.example.com.", dns.TypeA)
+
+	queries := tracker.snapshot()
+	require.Len(t, queries, 2)
+	require.Equal(t, "a.example.com.", queries[0].qname)
+	require.Equal(t, "b.example.com.", queries[1].qname)
+}
+
+func TestHotQueryTrackerCopiesScratchBuffers(t *testing.T) {
+	tracker := newHotQueryTracker(1)
+	packed := make([]byte, 255)
+	offset, _ := dns.PackDomainName("a.example.com.", packed, 0, nil, false)
+	loc := &db.Location{MapID: []byte{0, 0}, LocID: []byte{0, 42}}
+	for i := 0; i < hotQuerySampleRate; i++ {
+		tracker.record(packed[:offset], "a.example.com.", dns.TypeA, loc)
+	}
+	// clobber the scratch buffers, as the per-request pools would
+	for i := range packed {
+		packed[i] = 0xff
+	}
+	loc.LocID[1] = 0xff
+
+	queries := tracker.snapshot()
+	require.Len(t, queries, 1)
+	require.Equal(t, byte('a'), queries[0].packedQName[1])
+	require.Equal(t, []byte{0, 42}, queries[0].loc.LocID)
+}
@@ -28,12 +28,19 @@ import (
 
 // ServerConfig represent the configuration for a given DNS server
 type ServerConfig struct {
-	IPAns          ipAns
-	Port           int
-	MaxUDPSize     int
-	TCP            bool
-	TLS            bool
-	ReusePort      int
+	IPAns      ipAns
+	Port       int
+	MaxUDPSize int
+	TCP        bool
+	TLS        bool
+	ReusePort  int
+	// UDPBatchSize > 0 replaces the stock per-packet UDP read/write path
+	// with a recvmmsg/sendmmsg engine using batches of that many messages
+	UDPBatchSize int
+	// TCPMaxPipeline > 0 replaces the stock in-order TCP/DoT serving with a
+	// pipelined engine that answers the queries on a connection out of
+	// order, holding at most that many queries in flight per connection
+	TCPMaxPipeline int
 	MaxTCPQueries  int
 	TCPIdleTimeout time.Duration
 	ReadTimeout    time.Duration
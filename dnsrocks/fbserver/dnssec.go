@@ -14,6 +14,8 @@ limitations under the License.
 package fbserver
 
 import (
+	"context"
+	"net"
 	"strings"
 
 	"github.com/coredns/coredns/plugin"
@@ -28,6 +30,12 @@ import (
 type DNSSECConfig struct {
 	Zones string
 	Keys  string
+	// CacheSize overrides the default RRSIG cache capacity when positive.
+	CacheSize int
+	// Precompute signs the apex sets (SOA, NS, DNSKEY) of every zone when
+	// the handler is created, so the hottest signatures are served from
+	// the RRSIG cache from the first query on.
+	Precompute bool
 }
 
 const (
@@ -120,5 +128,45 @@ func newDNSSECHandler(srv *Server, next plugin.Handler) (dnssec.Dnssec, error) {
 	if err != nil {
 		return dnssec.Dnssec{}, err
 	}
-	return dnssec.New(zones, keys, splitkeys, next, ca), nil
+	if srv.conf.DNSSECConfig.CacheSize > 0 {
+		ca = cache.New(srv.conf.DNSSECConfig.CacheSize)
+	}
+	handler := dnssec.New(zones, keys, splitkeys, next, ca)
+	if srv.conf.DNSSECConfig.Precompute {
+		go precomputeRRSIGs(handler, zones)
+	}
+	return handler, nil
+}
+
+// warmWriter is the ResponseWriter used for the RRSIG precompute pass. The
+// responses only matter for their side effect of populating the signature
+// cache, so it discards them.
+type warmWriter struct{}
+
+func (warmWriter) LocalAddr() net.Addr         { return &net.UDPAddr{IP: net.IPv6loopback, Port: 53} }
+func (warmWriter) RemoteAddr() net.Addr        { return &net.UDPAddr{IP: net.IPv6loopback, Port: 53} }
+func (warmWriter) WriteMsg(_ *dns.Msg) error   { return nil }
+func (warmWriter) Write(b []byte) (int, error) { return len(b), nil }
+func (warmWriter) Close() error                { return nil }
+func (warmWriter) TsigStatus() error           { return nil }
+func (warmWriter) TsigTimersOnly(_ bool)       {}
+func (warmWriter) Hijack()                     {}
+
+// precomputeRRSIGs runs the apex sets of every zone through the DNSSEC
+// handler once, so their signatures are computed and cached before real
+// queries arrive. Negative answers are not warmed: their NSEC records depend
+// on the queried name, though the SOA signature they carry is covered here.
+func precomputeRRSIGs(handler dnssec.Dnssec, zones []string) {
+	qtypes := []uint16{dns.TypeSOA, dns.TypeNS, dns.TypeDNSKEY}
+	for _, zone := range zones {
+		for _, qtype := range qtypes {
+			m := new(dns.Msg)
+			m.SetQuestion(zone, qtype)
+			m.SetEdns0(4096, true)
+			if _, err := handler.ServeDNS(context.Background(), warmWriter{}, m); err != nil {
+				glog.Errorf("failed to precompute RRSIG for %s %s: %v", zone, dns.TypeToString[qtype], err)
+			}
+		}
+	}
+	glog.Infof("Precomputed RRSIGs for %d zone(s)", len(zones))
 }
@@ -14,11 +14,13 @@ limitations under the License.
 package fbserver
 
 import (
+	"crypto/tls"
 	"errors"
 	"fmt"
 	"io"
 	"log"
 	"net"
+	"runtime"
 	"strconv"
 	"strings"
 	"sync"
@@ -45,6 +47,8 @@ type Server struct {
 	conf            ServerConfig
 	db              *dnsserver.FBDNSDB
 	servers         []*dns.Server
+	batchServers    []*batchedUDPServer
+	pipelineServers []*pipelinedTCPServer
 	stats           stats.Stats
 	metricsExporter anyMetricsExporter
 	// If NotifyStartedFunc is set it is called once the server has started listening.
@@ -151,6 +155,33 @@ func (srv *Server) initUDPServer(addr string, h dns.Handler) (*dns.Server, error
 	}, nil
 }
 
+// startBatchedUDPServer opens a UDP socket served by the recvmmsg/sendmmsg
+// engine instead of a stock dns.Server, and starts it. Handler workers are
+// spread so that all listeners for an address together use about one worker
+// per core.
+func (srv *Server) startBatchedUDPServer(addr string, h dns.Handler, s *metrics.Stats, numListeners int) error {
+	pc, err := listenUDP(addr, srv.listenConf())
+	if err != nil {
+		return fmt.Errorf("failed to init batched UDP server: %w", err)
+	}
+	workers := runtime.NumCPU() / numListeners
+	bs, err := newBatchedUDPServer(pc, h, s, srv.conf.UDPBatchSize, workers)
+	if err != nil {
+		return err
+	}
+	bs.NotifyStartedFunc = srv.NotifyStartedFunc
+	srv.batchServers = append(srv.batchServers, bs)
+	// Server never calls Done() method, it only provides
+	// this wg for client to use.
+	srv.ServersStartedWG.Add(1)
+	go func() {
+		if err := bs.ActivateAndServe(); err != nil {
+			glog.Errorf("batched UDP server for %s failed: %v", addr, err)
+		}
+	}()
+	return nil
+}
+
 // initTCPServer opens a monitored TCP socket and returns a DNS server ready
 // for ActivateAndServe.
 func (srv *Server) initTCPServer(addr string, h dns.Handler, s *metrics.Stats) (*dns.Server, error) {
@@ -167,13 +198,45 @@ func (srv *Server) initTCPServer(addr string, h dns.Handler, s *metrics.Stats) (
 	}, nil
 }
 
-// initTLSServer loads TLS certificates and session keys, before opening a
-// monitored TCP/TLS socket and returns a DNS server ready for ActivateAndServe.
-func (srv *Server) initTLSServer(addr string, h dns.Handler, conf *tlsconfig.TLSConfig, s *metrics.Stats) (*dns.Server, error) {
-	tlsConf, err := tlsconfig.InitTLSConfig(conf)
+// startPipelinedTCPServer opens a monitored TCP (or, when tlsConf is given,
+// TCP/TLS) socket served by the out-of-order pipelining engine instead of a
+// stock dns.Server, and starts it.
+func (srv *Server) startPipelinedTCPServer(addr string, h dns.Handler, s *metrics.Stats, tlsConf *tls.Config) error {
+	var (
+		l    *Monitor
+		name MonitorType
+		err  error
+	)
+	if tlsConf != nil {
+		name = monitorTCPWithTLS
+		l, err = listenTLS(addr, srv.listenConf(), tlsConf, s)
+	} else {
+		name = monitorTCP
+		l, err = listenTCP(addr, srv.listenConf(), s)
+	}
 	if err != nil {
-		return nil, fmt.Errorf("failed to init TLS config: %w", err)
+		return fmt.Errorf("failed to init pipelined %s server: %w", name, err)
 	}
+	ps := newPipelinedTCPServer(l, h, s, name, srv.conf.TCPMaxPipeline)
+	ps.maxQueries = srv.conf.MaxTCPQueries
+	ps.readTimeout = srv.conf.ReadTimeout
+	ps.idleTimeout = srv.conf.TCPIdleTimeout
+	ps.NotifyStartedFunc = srv.NotifyStartedFunc
+	srv.pipelineServers = append(srv.pipelineServers, ps)
+	// Server never calls Done() method, it only provides
+	// this wg for client to use.
+	srv.ServersStartedWG.Add(1)
+	go func() {
+		if err := ps.ActivateAndServe(); err != nil {
+			glog.Errorf("pipelined %s server for %s failed: %v", name, addr, err)
+		}
+	}()
+	return nil
+}
+
+// initTLSServer opens a monitored TCP/TLS socket and returns a DNS server
+// ready for ActivateAndServe.
+func (srv *Server) initTLSServer(addr string, h dns.Handler, tlsConf *tls.Config, s *metrics.Stats) (*dns.Server, error) {
 	l, err := listenTLS(addr, srv.listenConf(), tlsConf, s)
 	if err != nil {
 		return nil, fmt.Errorf("failed to init TCP/TLS server: %w", err)
@@ -192,12 +255,27 @@ func (srv *Server) initTLSServer(addr string, h dns.Handler, conf *tlsconfig.TLS
 // listeners.
 func (srv *Server) listenConf() net.ListenConfig {
 	conf := net.ListenConfig{}
-	if srv.conf.ReusePort > 0 {
+	if srv.conf.ReusePort != 0 {
 		conf = net.ListenConfig{Control: reusePort}
 	}
 	return conf
 }
 
+// numListeners returns how many SO_REUSEPORT sockets to open per address:
+// the configured count, one socket per CPU core in auto mode (ReusePort < 0)
+// so receive work spreads across cores, or a single socket when
+// SO_REUSEPORT is disabled. Each socket gets its own dns.Server and
+// therefore its own read loop.
+func (srv *Server) numListeners() int {
+	if srv.conf.ReusePort < 0 {
+		return runtime.NumCPU()
+	}
+	if srv.conf.ReusePort == 0 {
+		return 1
+	}
+	return srv.conf.ReusePort
+}
+
 // Start iterates through a list of configured IPs, and starts a separate
 // goroutine to handle DNS requests on the protocols enabled in the
 // configuration. Start does not block, and the servers may fail with fatal
@@ -210,14 +288,9 @@ func (srv *Server) Start() (err error) {
 		dotTLSAHandler   *dotTLSAHandler
 		anyHandler       *anyHandler
 		nsidHandler      *nsid.Handler
-		numListeners     = srv.conf.ReusePort
+		numListeners     = srv.numListeners()
 	)
 
-	// We have at least 1 listener
-	if numListeners == 0 {
-		numListeners = 1
-	}
-
 	// DNS connection stats
 	stats := metrics.NewStats()
 	err = srv.metricsExporter.ConsumeStats(connectionKey, stats)
@@ -229,6 +302,18 @@ func (srv *Server) Start() (err error) {
 		return srv.conf.TCPIdleTimeout
 	}
 
+	// All TLS listeners share one config, and with it one set of session
+	// ticket keys rotated by a single manager. A resolver reconnecting to
+	// any SO_REUSEPORT listener or address can then resume the session it
+	// established on another, skipping the full handshake.
+	var tlsConf *tls.Config
+	if srv.conf.TLS {
+		tickets := tlsconfig.NewSessionTicketManager(&srv.conf.TLSConfig.SessionTicketKeys)
+		if tlsConf, err = tlsconfig.InitTLSConfigWithSessionTickets(&srv.conf.TLSConfig, tickets); err != nil {
+			return fmt.Errorf("failed to init TLS config: %w", err)
+		}
+	}
+
 	if srv.conf.TLSConfig.DoTTLSAEnabled {
 		glog.Infof("Enabling DoTTLSAHandler")
 		if !srv.conf.TLS {
@@ -322,25 +407,35 @@ func (srv *Server) Start() (err error) {
 
 		for i := 0; i < numListeners; i++ {
 			// UDP is the default, and is always run.
-			s, err := srv.initUDPServer(addr, handler)
-			if err != nil {
-				return err
-			}
-			s.ReadTimeout = srv.conf.ReadTimeout
-			s.NotifyStartedFunc = srv.NotifyStartedFunc
-			srv.servers = append(srv.servers, s)
-			// Server never calls Done() method, it only provides
-			// this wg for client to use.
-			srv.ServersStartedWG.Add(1)
-			go func() {
-				err := s.ActivateAndServe()
+			if srv.conf.UDPBatchSize > 0 {
+				if err := srv.startBatchedUDPServer(addr, handler, stats, numListeners); err != nil {
+					return err
+				}
+			} else {
+				s, err := srv.initUDPServer(addr, handler)
 				if err != nil {
-					glog.Infof("UDP server for %s failed to start: %v", addr, err)
+					return err
 				}
-			}()
+				s.ReadTimeout = srv.conf.ReadTimeout
+				s.NotifyStartedFunc = srv.NotifyStartedFunc
+				srv.servers = append(srv.servers, s)
+				// Server never calls Done() method, it only provides
+				// this wg for client to use.
+				srv.ServersStartedWG.Add(1)
+				go func() {
+					err := s.ActivateAndServe()
+					if err != nil {
+						glog.Infof("UDP server for %s failed to start: %v", addr, err)
+					}
+				}()
+			}
 
 			// Optionally start a TCP server for the address as well.
-			if srv.conf.TCP {
+			if srv.conf.TCP && srv.conf.TCPMaxPipeline > 0 {
+				if err := srv.startPipelinedTCPServer(addr, handler, stats, nil); err != nil {
+					return err
+				}
+			} else if srv.conf.TCP {
 				s, err := srv.initTCPServer(addr, handler, stats)
 				if err != nil {
 					return err
@@ -362,9 +457,14 @@ func (srv *Server) Start() (err error) {
 			}
 
 			// Optionally start a TLS server for the address as well.
-			if srv.conf.TLS {
+			if srv.conf.TLS && srv.conf.TCPMaxPipeline > 0 {
+				addr := joinAddress(ip, srv.conf.TLSConfig.Port)
+				if err := srv.startPipelinedTCPServer(addr, handler, stats, tlsConf); err != nil {
+					return err
+				}
+			} else if srv.conf.TLS {
 				addr := joinAddress(ip, srv.conf.TLSConfig.Port)
-				s, err := srv.initTLSServer(addr, handler, &srv.conf.TLSConfig, stats)
+				s, err := srv.initTLSServer(addr, handler, tlsConf, stats)
 				if err != nil {
 					return err
 				}
@@ -391,7 +491,7 @@ func (srv *Server) Start() (err error) {
 
 // Shutdown shuts down all the underlying servers and close the DB.
 func (srv *Server) Shutdown() {
-	glog.Infof("Shutting down %d servers", len(srv.servers))
+	glog.Infof("Shutting down %d servers", len(srv.servers)+len(srv.batchServers)+len(srv.pipelineServers))
 	for _, s := range srv.servers {
 		glog.Infof("Shutting down %s/%s", s.Addr, s.Net)
 		err := s.Shutdown()
@@ -399,6 +499,20 @@ func (srv *Server) Shutdown() {
 			glog.Errorf("%v", err)
 		}
 	}
+	for _, s := range srv.batchServers {
+		glog.Infof("Shutting down %s/udp (batched)", s.conn.LocalAddr())
+		err := s.Shutdown()
+		if err != nil {
+			glog.Errorf("%v", err)
+		}
+	}
+	for _, s := range srv.pipelineServers {
+		glog.Infof("Shutting down %s/%s (pipelined)", s.listener.Addr(), s.name)
+		err := s.Shutdown()
+		if err != nil {
+			glog.Errorf("%v", err)
+		}
+	}
 	srv.db.Close()
 }
 
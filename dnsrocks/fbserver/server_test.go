@@ -20,6 +20,7 @@ import (
 	"math"
 	"net"
 	"os"
+	"runtime"
 	"strconv"
 	"testing"
 	"time"
@@ -90,6 +91,12 @@ func makeTestServer(t testing.TB, config ServerConfig) (map[string]string, *Serv
 			m[s.Net] = s.PacketConn.LocalAddr().String()
 		}
 	}
+	for _, s := range srv.batchServers {
+		m["udp"] = s.conn.LocalAddr().String()
+	}
+	for _, s := range srv.pipelineServers {
+		m[string(s.name)] = s.listener.Addr().String()
+	}
 	return m, srv
 }
 
@@ -121,6 +128,20 @@ func RunUDPTLSTestServer(t *testing.T) (map[string]string, *Server) {
 	return makeTestServer(t, config)
 }
 
+// TestNumListeners checks listener count resolution for SO_REUSEPORT modes.
+func TestNumListeners(t *testing.T) {
+	config := makeTestServerConfig(false, false)
+	srv := &Server{conf: config}
+	// SO_REUSEPORT disabled: single listener
+	require.Equal(t, 1, srv.numListeners())
+	// explicit listener count
+	srv.conf.ReusePort = 4
+	require.Equal(t, 4, srv.numListeners())
+	// auto mode: one listener per core
+	srv.conf.ReusePort = -1
+	require.Equal(t, runtime.NumCPU(), srv.numListeners())
+}
+
 // TestRunUDPTestServer simple test to ensure that we only create a UDP server.
 func TestRunUDPTestServer(t *testing.T) {
 	portMap, srv := RunUDPTestServer(t)
@@ -183,6 +204,42 @@ func TestUDPDNSServerWithQueries(t *testing.T) {
 	}
 }
 
+// TestBatchedUDPDNSServerWithQueries runs the same queries against a UDP
+// server backed by the recvmmsg/sendmmsg engine.
+func TestBatchedUDPDNSServerWithQueries(t *testing.T) {
+	config := makeTestServerConfig(false, false)
+	config.UDPBatchSize = 8
+	portMap, srv := makeTestServer(t, config)
+	defer srv.Shutdown()
+
+	testCases := []struct {
+		qname  string
+		target string
+	}{
+		{
+			qname:  "foo2.example.com.",
+			target: "some-other.domain.",
+		},
+		{
+			qname:  "cnamemap.example.net.",
+			target: "bar.example.net.",
+		},
+	}
+	for _, tc := range testCases {
+		t.Run(tc.qname, func(t *testing.T) {
+			c := new(dns.Client)
+			m := new(dns.Msg)
+			m.SetQuestion(tc.qname, dns.TypeA)
+			r, _, err := c.Exchange(m, portMap["udp"])
+			require.Nil(t, err)
+			require.NotEqual(t, 0, len(r.Answer))
+
+			cname := r.Answer[0].(*dns.CNAME).Target
+			require.Equal(t, tc.target, cname)
+		})
+	}
+}
+
 // TestUDPDNSServerQueryMultipleQuestions creates a standalone UDP server and
 // test a query that contains multiple questions.
 // Since https://github.com/miekg/dns/commit/2c18e7259a35458cf282adbfa12b04de0d00c899
@@ -353,6 +410,46 @@ func TestTCPTimeout(t *testing.T) {
 	require.Equal(t, io.EOF, err, "Connection was expected to be closed by server")
 }
 
+// TestPipelinedTCPQueries confirms that queries pipelined on a single TCP
+// connection are all answered when the out-of-order engine is enabled, and
+// that the responses can be matched back to the queries by message ID.
+func TestPipelinedTCPQueries(t *testing.T) {
+	config := makeTestServerConfig(true, false)
+	config.TCPMaxPipeline = 8
+	config.TCPIdleTimeout = 2 * time.Second
+	portMap, srv := makeTestServer(t, config)
+	defer srv.Shutdown()
+
+	c := new(dns.Client)
+	c.Net = "tcp"
+	co, err := c.Dial(portMap["tcp"])
+	require.Nil(t, err, "Error connecting to server")
+	defer co.Close()
+
+	// write all the queries before reading a single response
+	const pipelined = 5
+	pending := make(map[uint16]bool, pipelined)
+	for i := 0; i < pipelined; i++ {
+		m := new(dns.Msg)
+		m.SetQuestion("foo2.example.com.", dns.TypeA)
+		m.Id = uint16(i + 1)
+		require.NoError(t, co.SetWriteDeadline(time.Now().Add(2*time.Second)))
+		require.NoError(t, co.WriteMsg(m), "Error writing message")
+		pending[m.Id] = true
+	}
+
+	// responses may arrive in any order
+	for i := 0; i < pipelined; i++ {
+		require.NoError(t, co.SetReadDeadline(time.Now().Add(2*time.Second)))
+		r, err := co.ReadMsg()
+		require.Nil(t, err, "Error reading message")
+		require.True(t, pending[r.Id], "Unexpected response ID %d", r.Id)
+		delete(pending, r.Id)
+		require.NotEqual(t, 0, len(r.Answer))
+	}
+	require.Empty(t, pending)
+}
+
 // TestMultipleQueryoverTCP confirm that we can send multiple queries over the
 // same TCP connection.
 func TestMultipleQueryoverTCP(t *testing.T) {
@@ -0,0 +1,239 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package fbserver
+
+import (
+	"encoding/binary"
+	"io"
+	"net"
+	"sync"
+	"time"
+
+	"github.com/golang/glog"
+	"github.com/miekg/dns"
+
+	"github.com/facebook/dns/dnsrocks/metrics"
+)
+
+// pipelinedTCPServer serves the queries pipelined on a TCP or DoT connection
+// out of order: a read loop keeps reading ahead on the connection, every
+// query is dispatched to its own handler goroutine bounded by a
+// per-connection in-flight cap, and responses are written as they complete.
+// DNS message IDs let the client match responses to queries, so reordering
+// is safe, and one slow lookup no longer head-of-line-blocks a resolver that
+// pipelined dozens of queries on a single connection. It replaces the stock
+// dns.Server - which answers strictly in read order - when
+// ServerConfig.TCPMaxPipeline > 0.
+type pipelinedTCPServer struct {
+	listener    net.Listener
+	handler     dns.Handler
+	stats       *metrics.Stats
+	name        MonitorType
+	maxInflight int
+	maxQueries  int // close the connection after this many queries, <= 0 is unlimited
+	readTimeout time.Duration
+	idleTimeout time.Duration
+
+	// NotifyStartedFunc is called once the server is about to accept.
+	NotifyStartedFunc func()
+
+	mu    sync.Mutex
+	conns map[net.Conn]struct{}
+	done  chan struct{}
+	wg    sync.WaitGroup
+}
+
+// newPipelinedTCPServer wraps an already listening socket
+func newPipelinedTCPServer(l net.Listener, h dns.Handler, s *metrics.Stats, name MonitorType, maxInflight int) *pipelinedTCPServer {
+	if maxInflight < 1 {
+		maxInflight = 1
+	}
+	srv := &pipelinedTCPServer{
+		listener:    l,
+		handler:     h,
+		stats:       s,
+		name:        name,
+		maxInflight: maxInflight,
+		conns:       make(map[net.Conn]struct{}),
+		done:        make(chan struct{}),
+	}
+	srv.stats.ResetCounter(formatMonitorStatName(name, "Read"))
+	srv.stats.ResetCounter(formatMonitorStatName(name, "Write"))
+	return srv
+}
+
+// ActivateAndServe accepts connections until Shutdown is called or the
+// listener fails; every connection gets its own read loop
+func (s *pipelinedTCPServer) ActivateAndServe() error {
+	if s.NotifyStartedFunc != nil {
+		s.NotifyStartedFunc()
+	}
+	for {
+		conn, err := s.listener.Accept()
+		if err != nil {
+			select {
+			case <-s.done:
+				s.wg.Wait()
+				return nil
+			default:
+			}
+			if ne, ok := err.(net.Error); ok && ne.Timeout() {
+				continue
+			}
+			s.wg.Wait()
+			return err
+		}
+		s.track(conn)
+		s.wg.Add(1)
+		go func() {
+			defer s.wg.Done()
+			s.serveConn(conn)
+		}()
+	}
+}
+
+// Shutdown closes the listener and all tracked connections;
+// ActivateAndServe returns once the in-flight queries are done
+func (s *pipelinedTCPServer) Shutdown() error {
+	close(s.done)
+	err := s.listener.Close()
+	s.mu.Lock()
+	for conn := range s.conns {
+		conn.Close()
+	}
+	s.mu.Unlock()
+	return err
+}
+
+func (s *pipelinedTCPServer) track(conn net.Conn) {
+	s.mu.Lock()
+	s.conns[conn] = struct{}{}
+	s.mu.Unlock()
+}
+
+func (s *pipelinedTCPServer) untrack(conn net.Conn) {
+	s.mu.Lock()
+	delete(s.conns, conn)
+	s.mu.Unlock()
+}
+
+// serveConn reads ahead on one connection and fans the queries out to
+// handler goroutines; it returns when the client goes away, idles out or
+// the query budget is spent. The connection is closed once the last
+// in-flight response has been written.
+func (s *pipelinedTCPServer) serveConn(conn net.Conn) {
+	var qwg sync.WaitGroup
+	inflight := make(chan struct{}, s.maxInflight)
+	w := &pipelineWriter{conn: conn, srv: s}
+
+	for q := 0; s.maxQueries <= 0 || q < s.maxQueries; q++ {
+		buf, err := s.readMsg(conn, q == 0)
+		if err != nil {
+			break
+		}
+		s.stats.IncrementCounter(formatMonitorStatName(s.name, "Read"))
+		req := new(dns.Msg)
+		if err := req.Unpack(buf); err != nil {
+			glog.V(2).Infof("dropping malformed TCP message from %s: %v", conn.RemoteAddr(), err)
+			break
+		}
+		inflight <- struct{}{}
+		qwg.Add(1)
+		go func() {
+			defer qwg.Done()
+			defer func() { <-inflight }()
+			s.handler.ServeDNS(w, req)
+		}()
+	}
+	qwg.Wait()
+	s.untrack(conn)
+	conn.Close()
+}
+
+// readMsg reads one length-prefixed DNS message; the first read on a
+// connection uses the read timeout, later ones the idle timeout
+func (s *pipelinedTCPServer) readMsg(conn net.Conn, first bool) ([]byte, error) {
+	timeout := s.idleTimeout
+	if first {
+		timeout = s.readTimeout
+	}
+	if timeout > 0 {
+		if err := conn.SetReadDeadline(time.Now().Add(timeout)); err != nil {
+			return nil, err
+		}
+	}
+	var length uint16
+	if err := binary.Read(conn, binary.BigEndian, &length); err != nil {
+		return nil, err
+	}
+	buf := make([]byte, length)
+	if _, err := io.ReadFull(conn, buf); err != nil {
+		return nil, err
+	}
+	return buf, nil
+}
+
+// pipelineWriter is the dns.ResponseWriter shared by the in-flight queries
+// of one connection; the write mutex keeps the length-prefixed responses
+// from interleaving
+type pipelineWriter struct {
+	conn net.Conn
+	srv  *pipelinedTCPServer
+	wmu  sync.Mutex
+}
+
+// LocalAddr returns the address of the listening socket
+func (w *pipelineWriter) LocalAddr() net.Addr { return w.conn.LocalAddr() }
+
+// RemoteAddr returns the address of the connected client
+func (w *pipelineWriter) RemoteAddr() net.Addr { return w.conn.RemoteAddr() }
+
+// WriteMsg packs the response and writes it out
+func (w *pipelineWriter) WriteMsg(m *dns.Msg) error {
+	packed, err := m.Pack()
+	if err != nil {
+		return err
+	}
+	_, err = w.Write(packed)
+	return err
+}
+
+// Write sends one length-prefixed response; responses from concurrent
+// handlers are serialized on the write mutex
+func (w *pipelineWriter) Write(b []byte) (int, error) {
+	w.wmu.Lock()
+	defer w.wmu.Unlock()
+	var length [2]byte
+	binary.BigEndian.PutUint16(length[:], uint16(len(b)))
+	if _, err := w.conn.Write(length[:]); err != nil {
+		return 0, err
+	}
+	n, err := w.conn.Write(b)
+	if err == nil {
+		w.srv.stats.IncrementCounter(formatMonitorStatName(w.srv.name, "Write"))
+	}
+	return n, err
+}
+
+// Close closes the underlying connection
+func (w *pipelineWriter) Close() error { return w.conn.Close() }
+
+// TsigStatus is always nil - TSIG is not supported on this path
+func (w *pipelineWriter) TsigStatus() error { return nil }
+
+// TsigTimersOnly is a noop - TSIG is not supported on this path
+func (w *pipelineWriter) TsigTimersOnly(bool) {}
+
+// Hijack is a noop: the connection is shared between all in-flight queries
+func (w *pipelineWriter) Hijack() {}
@@ -72,6 +72,54 @@ func New(r io.ReaderAt) *Cdb {
 	return c
 }
 
+// PrefetchIndex asks the kernel to read ahead the header and the hash
+// table region of the database. The hash tables sit at the end of a cdb
+// file after the records, so every lookup starts with a read there; on a
+// cold mapping those are the page faults that hurt first-query latency the
+// most. Advisory and asynchronous, safe on files larger than memory.
+func (c *Cdb) PrefetchIndex() {
+	if uint32(len(c.mmappedData)) < headerSize {
+		return
+	}
+	portablemmap.Willneed(c.mmappedData[:headerSize])
+
+	// The hash tables span from the lowest table position referenced by
+	// the header to the end of the file.
+	minHpos := uint32(len(c.mmappedData))
+	context := NewContext()
+	for i := 0; i < 256; i++ {
+		hpos, hslots := c.readNums(uint32(i)<<3, context)
+		if hslots != 0 && hpos < minHpos {
+			minHpos = hpos
+		}
+	}
+	if minHpos < uint32(len(c.mmappedData)) {
+		portablemmap.Willneed(c.mmappedData[minHpos:])
+	}
+}
+
+// AdviseHugepage makes the mapping eligible for transparent huge pages,
+// reducing TLB pressure on large databases. No-op outside Linux.
+func (c *Cdb) AdviseHugepage() {
+	portablemmap.Hugepage(c.mmappedData)
+}
+
+// warmupSink keeps the Warmup page walk from being optimized away.
+var warmupSink byte
+
+// Warmup walks the whole mapping touching one byte per page, faulting the
+// entire database into the page cache. Unlike PrefetchIndex this blocks
+// until every page is resident, so do not call it on databases larger than
+// the available physical memory.
+func (c *Cdb) Warmup() {
+	pageSize := os.Getpagesize()
+	var sum byte
+	for i := 0; i < len(c.mmappedData); i += pageSize {
+		sum += c.mmappedData[i]
+	}
+	warmupSink = sum
+}
+
 // NewContext returns a new context to be used in CDB calls.
 func NewContext() *Context {
 	// Zero values for the context are ok, so no need to set them
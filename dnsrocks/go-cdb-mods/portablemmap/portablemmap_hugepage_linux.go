@@ -0,0 +1,9 @@
+package portablemmap
+
+import "syscall"
+
+func Hugepage(mmappedData []byte) {
+	// Makes the region eligible for transparent huge pages, cutting TLB
+	// pressure on large mappings. Only meaningful on Linux.
+	madvise(mmappedData, syscall.MADV_HUGEPAGE)
+}
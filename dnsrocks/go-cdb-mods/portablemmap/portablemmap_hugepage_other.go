@@ -0,0 +1,8 @@
+//go:build !linux
+// +build !linux
+
+package portablemmap
+
+func Hugepage(mmappedData []byte) {
+	// Transparent huge pages are Linux-only. This is a no-op elsewhere.
+}
@@ -10,14 +10,27 @@ import (
 	"unsafe"
 )
 
+func madvise(mmappedData []byte, advice int) {
+	if len(mmappedData) == 0 {
+		return
+	}
+	sliceHeader := *(*reflect.SliceHeader)(unsafe.Pointer(&mmappedData))
+	syscall.Syscall(syscall.SYS_MADVISE, sliceHeader.Data,
+		uintptr(sliceHeader.Len), uintptr(advice))
+}
+
 func Prefault(mmappedData []byte) {
 	// Prefaults mmaped file so it is preloaded in the filesystem cache.
 	// Note that you should *NOT* call this if the CDB file is bigger than
 	// the available physical memory.
-	sliceHeader := *(*reflect.SliceHeader)(unsafe.Pointer(&mmappedData))
-	syscall.Syscall(syscall.SYS_MSYNC, uintptr(sliceHeader.Data),
-		uintptr(sliceHeader.Len), uintptr(
-			syscall.MADV_WILLNEED|syscall.MADV_RANDOM))
+	madvise(mmappedData, syscall.MADV_WILLNEED)
+}
+
+func Willneed(mmappedData []byte) {
+	// Asks the kernel to start reading the given region ahead of actual
+	// accesses. Purely advisory and asynchronous, so it is cheap to call
+	// on a sub-region (e.g. an index) of an arbitrarily large file.
+	madvise(mmappedData, syscall.MADV_WILLNEED)
 }
 
 func Mmap(f *os.File) ([]byte, error) {
@@ -16,6 +16,10 @@ func Prefault(mmapedData []byte) {
 	// This is a no-op on Windows.
 }
 
+func Willneed(mmappedData []byte) {
+	// This is a no-op on Windows.
+}
+
 func Mmap(f *os.File) ([]byte, error) {
 	// Stat the file so we can know its size. We always maps the entire
 	// file.
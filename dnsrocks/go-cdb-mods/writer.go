@@ -5,6 +5,8 @@ import (
 	"hash"
 	"io"
 	"os"
+	"runtime"
+	"sync"
 )
 
 // Writer is the interface to be used by constant database writers. Its methods
@@ -20,6 +22,18 @@ type Writer interface {
 // NewWriter returns a constant database writer that uses go-cdb as its
 // implementation.
 func NewWriter(fileName string) (Writer, error) {
+	return NewParallelWriter(fileName, 1)
+}
+
+// NewParallelWriter returns a constant database writer that shards the hash
+// table construction on Close by table number across the given number of
+// workers, 0 or less meaning one per CPU. The produced file is byte for byte
+// identical to the one NewWriter emits.
+func NewParallelWriter(fileName string, workers int) (Writer, error) {
+	if workers < 1 {
+		workers = runtime.NumCPU()
+	}
+
 	f, err := os.Create(fileName)
 	if err != nil {
 		return nil, err
@@ -38,6 +52,7 @@ func NewWriter(fileName string) (Writer, error) {
 		nil,
 		make(map[uint32][]slot),
 		headerSize,
+		workers,
 	}
 
 	newWriter.hw = io.MultiWriter(newWriter.hash, newWriter.wb)
@@ -55,6 +70,7 @@ type writer struct {
 	hw      io.Writer
 	htables map[uint32][]slot
 	pos     uint32
+	workers int
 }
 
 func (w *writer) Put(key, value []byte) error {
@@ -87,6 +103,10 @@ func (w *writer) Put(key, value []byte) error {
 }
 
 func (w *writer) Close() error {
+	if w.workers > 1 {
+		return w.closeParallel()
+	}
+
 	maxSlots := 0
 	for _, slots := range w.htables {
 		if len(slots) > maxSlots {
@@ -146,3 +166,87 @@ func (w *writer) Close() error {
 
 	return err
 }
+
+// closeParallel writes the same file layout as Close, but shards the hash
+// table construction by table number across workers. A table position only
+// depends on the sizes of the tables before it, which are all known up
+// front, so the workers can lay out their tables into private buffers which
+// are then stitched together in file order.
+func (w *writer) closeParallel() error {
+	header := make([]byte, headerSize)
+
+	pos := w.pos
+	for i := uint32(0); i < 256; i++ {
+		slots := w.htables[i]
+		if slots == nil {
+			putNum(header[i*8:], pos)
+			continue
+		}
+		nslots := uint32(len(slots) * 2)
+		putNum(header[i*8:], pos)
+		putNum(header[i*8+4:], nslots)
+		pos += 8 * nslots
+	}
+
+	bufs := make([][]byte, 256)
+	var wg sync.WaitGroup
+	for worker := 0; worker < w.workers; worker++ {
+		wg.Add(1)
+		go func(worker int) {
+			defer wg.Done()
+			for i := worker; i < 256; i += w.workers {
+				if slots := w.htables[uint32(i)]; slots != nil {
+					bufs[i] = buildSlotTable(slots)
+				}
+			}
+		}(worker)
+	}
+	wg.Wait()
+
+	for _, buf := range bufs {
+		if buf == nil {
+			continue
+		}
+		if _, err := w.wb.Write(buf); err != nil {
+			return err
+		}
+	}
+	w.pos = pos
+
+	if err := w.wb.Flush(); err != nil {
+		return err
+	}
+
+	if _, err := w.w.Seek(0, 0); err != nil {
+		return err
+	}
+
+	_, err := w.w.Write(header)
+
+	return err
+}
+
+// buildSlotTable lays out one hash table and serializes it
+func buildSlotTable(slots []slot) []byte {
+	nslots := uint32(len(slots) * 2)
+	table := make([]slot, nslots)
+
+	for _, slot := range slots {
+		slotPos := (slot.h / 256) % nslots
+		for table[slotPos].pos != 0 {
+			slotPos++
+			if slotPos == nslots {
+				slotPos = 0
+			}
+		}
+		table[slotPos] = slot
+	}
+
+	buf := make([]byte, 8*nslots)
+	for j, np := range table {
+		putNum(buf[j*8:], np.h)
+		putNum(buf[j*8+4:], np.pos)
+	}
+
+	return buf
+}
@@ -2,8 +2,10 @@ package cdb
 
 import (
 	"bytes"
+	"fmt"
 	"io"
 	"os"
+	"path"
 	"testing"
 )
 
@@ -63,6 +65,67 @@ func TestWriter(t *testing.T) {
 	}
 }
 
+func TestParallelWriterMatchesSequential(t *testing.T) {
+	tmpDir := t.TempDir()
+	seqName := path.Join(tmpDir, "seq.cdb")
+	parName := path.Join(tmpDir, "par.cdb")
+
+	fill := func(w Writer) {
+		for i := 0; i < 1000; i++ {
+			key := append([]byte{byte(0)}, []byte(fmt.Sprintf("key-%d", i))...)
+			if err := w.Put(key, []byte(fmt.Sprintf("value-%d", i))); err != nil {
+				t.Fatalf("Error inserting db data : %s", err)
+			}
+		}
+		if err := w.Close(); err != nil {
+			t.Fatalf("Error closing db : %s", err)
+		}
+	}
+
+	seq, err := NewWriter(seqName)
+	if err != nil {
+		t.Fatalf("Error creating new Writer : %s", err)
+	}
+	fill(seq)
+
+	par, err := NewParallelWriter(parName, 4)
+	if err != nil {
+		t.Fatalf("Error creating new parallel Writer : %s", err)
+	}
+	fill(par)
+
+	seqData, err := os.ReadFile(seqName)
+	if err != nil {
+		t.Fatalf("Error reading database : %s", err)
+	}
+	parData, err := os.ReadFile(parName)
+	if err != nil {
+		t.Fatalf("Error reading database : %s", err)
+	}
+	if !bytes.Equal(seqData, parData) {
+		t.Fatal("parallel writer output differs from sequential writer output")
+	}
+
+	// And the records can be read back.
+	c, err := Open(parName)
+	if err != nil {
+		t.Fatalf("Error opening database : %s", err)
+	}
+	defer c.Close()
+
+	context := NewContext()
+	for i := 0; i < 1000; i++ {
+		key := append([]byte{byte(0)}, []byte(fmt.Sprintf("key-%d", i))...)
+		v, err := c.Data(key, context)
+		if err != nil {
+			t.Fatalf("Record read failed: %s", err)
+		}
+		if !bytes.Equal(v, []byte(fmt.Sprintf("value-%d", i))) {
+			t.Fatal("Incorrect value returned")
+		}
+	}
+}
+
 func createDatabaseWithWriter(t *testing.T) string {
 	name := "./test.cdb"
 
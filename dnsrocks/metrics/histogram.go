@@ -0,0 +1,155 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package metrics
+
+import (
+	"errors"
+	"math"
+	"math/bits"
+	"sync"
+	"time"
+)
+
+// histogramBuckets is the number of fixed power-of-two buckets. Bucket b
+// holds values in (2^(b-1), 2^b], so 40 buckets cover 1ns up to ~9 minutes
+// when the samples are nanosecond latencies; larger values clamp into the
+// last bucket.
+const histogramBuckets = 40
+
+type histogramCell [histogramBuckets]int64
+
+// slidingHistogram is the percentile-capable sibling of slidingWindow:
+// fixed power-of-two buckets aggregated per second, with the same
+// ring-of-cells lookback so percentiles always describe the last
+// sampleLifetime seconds. Buckets trade precision (a factor of two) for a
+// constant, allocation-free Add.
+type slidingHistogram struct {
+	mutex          sync.RWMutex
+	sampleLifetime time.Duration
+	cells          []histogramCell
+	pointer        int
+	stopping       chan struct{}
+}
+
+func newHistogram(sampleLifetime time.Duration) (*slidingHistogram, error) {
+	if sampleLifetime == 0 {
+		return nil, errors.New("sliding histogram cannot be zero")
+	}
+	secs := int(math.Ceil(sampleLifetime.Seconds()))
+
+	return &slidingHistogram{
+		sampleLifetime: sampleLifetime,
+		cells:          make([]histogramCell, secs),
+		stopping:       make(chan struct{}, 1),
+	}, nil
+}
+
+// newSlidingHistogram creates a new slidingHistogram and launches the cleaner coroutine
+func newSlidingHistogram(sampleLifetime time.Duration) (*slidingHistogram, error) {
+	h, err := newHistogram(sampleLifetime)
+	if err != nil {
+		return nil, err
+	}
+	go h.cleaner()
+	return h, nil
+}
+
+// refresh moves pointer to next cell and resets this cell content
+func (sh *slidingHistogram) refresh() {
+	sh.mutex.Lock()
+	sh.pointer++
+	if sh.pointer >= len(sh.cells) {
+		sh.pointer = 0
+	}
+	sh.cells[sh.pointer] = histogramCell{}
+	sh.mutex.Unlock()
+}
+
+func (sh *slidingHistogram) cleaner() {
+	ticker := time.NewTicker(time.Second)
+	for {
+		select {
+		case <-ticker.C:
+			sh.refresh()
+		case <-sh.stopping:
+			return
+		}
+	}
+}
+
+// bucketFor returns the histogram bucket for a value
+func bucketFor(v int64) int {
+	if v <= 0 {
+		return 0
+	}
+	b := bits.Len64(uint64(v)) - 1
+	if uint64(v) > 1<<b {
+		b++
+	}
+	if b >= histogramBuckets {
+		b = histogramBuckets - 1
+	}
+	return b
+}
+
+// Add adds a new sample into the sliding histogram
+func (sh *slidingHistogram) Add(v int64) {
+	b := bucketFor(v)
+	sh.mutex.Lock()
+	defer sh.mutex.Unlock()
+	for i := 0; i < len(sh.cells); i++ {
+		sh.cells[i][b]++
+	}
+}
+
+// Percentiles returns the requested percentiles (0 < q <= 1) over the last
+// sampleLifetime seconds. Each value reported is the upper bound of the
+// bucket holding that percentile's sample. The bool is false when the
+// histogram holds no samples.
+func (sh *slidingHistogram) Percentiles(qs ...float64) ([]int64, bool) {
+	sh.mutex.RLock()
+	// report data from the last cell (the one that will be overwritten on
+	// next refresh), as it aggregates the last sampleLifetime seconds
+	oldest := sh.pointer + 1
+	if oldest >= len(sh.cells) {
+		oldest = 0
+	}
+	cell := sh.cells[oldest]
+	sh.mutex.RUnlock()
+
+	var total int64
+	for _, count := range cell {
+		total += count
+	}
+	if total == 0 {
+		return nil, false
+	}
+
+	res := make([]int64, len(qs))
+	for i, q := range qs {
+		rank := int64(math.Ceil(q * float64(total)))
+		if rank < 1 {
+			rank = 1
+		}
+		var seen int64
+		for b, count := range cell {
+			seen += count
+			if seen >= rank {
+				res[i] = int64(1) << b
+				break
+			}
+		}
+	}
+	return res, true
+}
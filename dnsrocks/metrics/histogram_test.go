@@ -0,0 +1,79 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package metrics
+
+import (
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestBucketFor(t *testing.T) {
+	require.Equal(t, 0, bucketFor(0))
+	require.Equal(t, 0, bucketFor(1))
+	require.Equal(t, 1, bucketFor(2))
+	require.Equal(t, 2, bucketFor(3))
+	require.Equal(t, 2, bucketFor(4))
+	require.Equal(t, 10, bucketFor(1024))
+	require.Equal(t, 11, bucketFor(1025))
+	// values beyond the covered range clamp into the last bucket
+	require.Equal(t, histogramBuckets-1, bucketFor(int64(1)<<62))
+}
+
+func TestSlidingHistogramPercentiles(t *testing.T) {
+	// create histogram without background cleaning goroutine
+	sh, err := newHistogram(time.Second * 3)
+	require.NoError(t, err)
+
+	_, ok := sh.Percentiles(0.5)
+	require.False(t, ok, "no samples yet")
+
+	// 99 fast samples and one slow outlier
+	for i := 0; i < 99; i++ {
+		sh.Add(1000) // bucket upper bound 1024
+	}
+	sh.Add(1 << 20)
+
+	ps, ok := sh.Percentiles(0.5, 0.99, 1.0)
+	require.True(t, ok)
+	require.Equal(t, int64(1024), ps[0])
+	require.Equal(t, int64(1024), ps[1])
+	require.Equal(t, int64(1)<<20, ps[2])
+}
+
+func TestSlidingHistogramClean(t *testing.T) {
+	sh, err := newHistogram(time.Second * 2)
+	require.NoError(t, err)
+	sh.Add(8)
+	sh.refresh() // one second passed
+	ps, ok := sh.Percentiles(1.0)
+	require.True(t, ok, "sample still visible after one second")
+	require.Equal(t, int64(8), ps[0])
+	sh.refresh() // two seconds passed
+	sh.refresh() // three seconds passed
+	_, ok = sh.Percentiles(1.0)
+	require.False(t, ok, "sample aged out")
+}
+
+func BenchmarkSlidingHistogramAdd(b *testing.B) {
+	// create histogram without background cleaning goroutine
+	sh, err := newHistogram(time.Second * 2)
+	if err != nil {
+		b.Fatalf("failed to create histogram: %v", err)
+	}
+	for n := 0; n < b.N; n++ {
+		sh.Add(int64(n))
+	}
+}
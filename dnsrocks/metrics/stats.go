@@ -30,10 +30,14 @@ import (
 // * ResetCounterTo resets the counter to `value`
 // * Get to export them.
 type Stats struct {
-	vlock   sync.RWMutex
-	wlock   sync.RWMutex
-	values  map[string]int64
-	windows map[string]*slidingWindow
+	// counters maps key -> *stripedCounter. sync.Map keeps the hot path
+	// (incrementing an existing counter) free of any shared mutable word
+	// beyond the counter's own stripe: the key set stabilizes quickly, so
+	// lookups stay on the lock-free read path.
+	counters   sync.Map
+	wlock      sync.RWMutex
+	windows    map[string]*slidingWindow
+	histograms map[string]*slidingHistogram
 }
 
 // NewStats creates a new stats counter.
@@ -44,41 +48,42 @@ type Stats struct {
 func NewStats() *Stats {
 	stats := new(Stats)
 
-	stats.values = make(map[string]int64)
 	stats.windows = make(map[string]*slidingWindow)
+	stats.histograms = make(map[string]*slidingHistogram)
 	return stats
 }
 
+// counter returns the striped counter for key, creating it on first use
+func (stats *Stats) counter(key string) *stripedCounter {
+	if c, ok := stats.counters.Load(key); ok {
+		return c.(*stripedCounter)
+	}
+	c, _ := stats.counters.LoadOrStore(key, newStripedCounter())
+	return c.(*stripedCounter)
+}
+
 // IncrementCounter increments the counter for key by 1.
 // Implements dnsserver.IncrementCounter interface.
 func (stats *Stats) IncrementCounter(key string) {
-	stats.vlock.Lock()
-	stats.values[key]++
-	stats.vlock.Unlock()
+	stats.counter(key).add(1)
 }
 
 // IncrementCounterBy adds Value to the counter for key
 // Implements dnsserver.IncrementCounterBy interface.
 func (stats *Stats) IncrementCounterBy(key string, value int64) {
-	stats.vlock.Lock()
-	stats.values[key] += value
-	stats.vlock.Unlock()
+	stats.counter(key).add(value)
 }
 
 // ResetCounter sets the counter for key to 0.
 // Implements dnsserver.ResetCounter interface.
 func (stats *Stats) ResetCounter(key string) {
-	stats.vlock.Lock()
-	stats.values[key] = 0
-	stats.vlock.Unlock()
+	stats.counter(key).resetTo(0)
 }
 
 // ResetCounterTo sets the counter for key to the given value.
 // Implements dnsserver.ResetCounterTo interface.
 func (stats *Stats) ResetCounterTo(key string, value int64) {
-	stats.vlock.Lock()
-	stats.values[key] = value
-	stats.vlock.Unlock()
+	stats.counter(key).resetTo(value)
 }
 
 // AddSample adds a sample to the sliding window identified by key
@@ -99,16 +104,27 @@ func (stats *Stats) AddSample(key string, value int64) {
 		win = winfound
 	}
 	win.Add(value)
+
+	hist, found := stats.histograms[key]
+	if !found {
+		newhist, err := newSlidingHistogram(60 * time.Second)
+		if err != nil {
+			glog.Errorf("failed to register new sliding histogram")
+			return
+		}
+		stats.histograms[key] = newhist
+		hist = newhist
+	}
+	hist.Add(value)
 }
 
 // Get implements export.Int interface
 func (stats *Stats) Get() map[string]int64 {
 	var ret = make(map[string]int64)
-	stats.vlock.Lock()
-	for key, val := range stats.values {
-		ret[key] = val
-	}
-	stats.vlock.Unlock()
+	stats.counters.Range(func(key, val interface{}) bool {
+		ret[key.(string)] = val.(*stripedCounter).sum()
+		return true
+	})
 	stats.wlock.Lock()
 	for key, val := range stats.windows {
 		s := val.Stats()
@@ -116,6 +132,12 @@ func (stats *Stats) Get() map[string]int64 {
 		ret[fmt.Sprintf("%s.max", key)] = s.max
 		ret[fmt.Sprintf("%s.avg", key)] = s.avg
 	}
+	for key, val := range stats.histograms {
+		if ps, ok := val.Percentiles(0.5, 0.99); ok {
+			ret[fmt.Sprintf("%s.p50", key)] = ps[0]
+			ret[fmt.Sprintf("%s.p99", key)] = ps[1]
+		}
+	}
 	stats.wlock.Unlock()
 	return ret
 }
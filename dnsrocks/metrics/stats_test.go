@@ -40,12 +40,18 @@ func TestStatsGet(t *testing.T) {
 		"foo.min":             1,
 		"foo.max":             6,
 		"foo.avg":             3,
+		"foo.p50":             4,
+		"foo.p99":             8,
 		"bar.min":             -777,
 		"bar.max":             28888,
 		"bar.avg":             16036,
+		"bar.p50":             32768,
+		"bar.p99":             32768,
 		"some.long.stuff.min": 1,
 		"some.long.stuff.max": 6,
 		"some.long.stuff.avg": 3,
+		"some.long.stuff.p50": 4,
+		"some.long.stuff.p99": 8,
 	}
 	require.Equal(t, want, got)
 }
@@ -0,0 +1,78 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package metrics
+
+import (
+	"math/rand/v2"
+	"runtime"
+	"sync/atomic"
+)
+
+// counterStripes is the number of independently updated cells per counter:
+// the next power of two above GOMAXPROCS, so a stripe can be picked with a
+// mask. More stripes than cores buys nothing, fewer reintroduces sharing.
+var counterStripes = counterStripeCount()
+
+func counterStripeCount() uint32 {
+	n := uint32(1)
+	for n < uint32(runtime.GOMAXPROCS(0)) && n < 128 {
+		n <<= 1
+	}
+	return n
+}
+
+// counterCell is one stripe, padded out to a typical cache line so that
+// neighbouring stripes never share one.
+type counterCell struct {
+	n atomic.Int64
+	_ [56]byte
+}
+
+// stripedCounter spreads increments of one logical counter over several
+// padded cells, so concurrent writers on different cores stop bouncing a
+// single cache line between them. Writers pick a stripe with the runtime's
+// per-P random source (lock-free, no shared state); readers sum the cells
+// at scrape time. The total is only ever read by Get, so the laziness is
+// free.
+type stripedCounter struct {
+	cells []counterCell
+}
+
+func newStripedCounter() *stripedCounter {
+	return &stripedCounter{cells: make([]counterCell, counterStripes)}
+}
+
+// add applies a delta to a randomly picked stripe
+func (c *stripedCounter) add(delta int64) {
+	c.cells[rand.Uint32()&(counterStripes-1)].n.Add(delta)
+}
+
+// resetTo sets the counter to the given value. Concurrent adds may land on
+// an already-zeroed stripe and survive the reset; counters are statistics,
+// that race is acceptable.
+func (c *stripedCounter) resetTo(value int64) {
+	for i := range c.cells {
+		c.cells[i].n.Store(0)
+	}
+	c.cells[0].n.Store(value)
+}
+
+// sum aggregates the stripes into the counter's current value
+func (c *stripedCounter) sum() int64 {
+	var total int64
+	for i := range c.cells {
+		total += c.cells[i].n.Load()
+	}
+	return total
+}
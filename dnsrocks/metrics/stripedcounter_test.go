@@ -0,0 +1,80 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package metrics
+
+import (
+	"sync"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestStripedCounterConcurrentAdds(t *testing.T) {
+	const workers, perWorker = 16, 10000
+	c := newStripedCounter()
+	var wg sync.WaitGroup
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := 0; i < perWorker; i++ {
+				c.add(1)
+			}
+		}()
+	}
+	wg.Wait()
+	require.Equal(t, int64(workers*perWorker), c.sum())
+}
+
+func TestStripedCounterReset(t *testing.T) {
+	c := newStripedCounter()
+	for i := 0; i < 100; i++ {
+		c.add(2)
+	}
+	c.resetTo(42)
+	require.Equal(t, int64(42), c.sum())
+	c.resetTo(0)
+	require.Equal(t, int64(0), c.sum())
+}
+
+func TestStatsCounters(t *testing.T) {
+	s := NewStats()
+	s.IncrementCounter("queries")
+	s.IncrementCounterBy("queries", 9)
+	s.ResetCounterTo("reloads", 3)
+	s.ResetCounter("errors")
+
+	got := s.Get()
+	require.Equal(t, int64(10), got["queries"])
+	require.Equal(t, int64(3), got["reloads"])
+	require.Equal(t, int64(0), got["errors"])
+}
+
+func BenchmarkStripedCounterAddParallel(b *testing.B) {
+	c := newStripedCounter()
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			c.add(1)
+		}
+	})
+}
+
+func BenchmarkStatsIncrementCounterParallel(b *testing.B) {
+	s := NewStats()
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			s.IncrementCounter("hot")
+		}
+	})
+}
@@ -14,17 +14,29 @@ limitations under the License.
 package tlsconfig
 
 import (
+	"crypto/rand"
 	"crypto/sha256"
 	"crypto/tls"
 	"encoding/json"
 	"fmt"
 	"io"
 	"os"
+	"sync"
 	"time"
 
 	"github.com/golang/glog"
 )
 
+const (
+	// sessionTicketKeyCount is how many ticket keys are kept when the
+	// manager generates its own: one current plus older ones still accepted
+	// for resumption.
+	sessionTicketKeyCount = 3
+	// sessionTicketRotationInterval is how often a fresh locally generated
+	// key replaces the oldest one.
+	sessionTicketRotationInterval = 24 * time.Hour
+)
+
 func sessionTicketFromSeed(seed string) (key [32]byte) {
 	h := sha256.New()
 	h.Write([]byte(seed))
@@ -32,7 +44,68 @@ func sessionTicketFromSeed(seed string) (key [32]byte) {
 	return
 }
 
-func loadSessionTicketFromFile(config *tls.Config, seedfile string) error {
+// SessionTicketManager owns the session ticket keys for all the TLS
+// listeners of a process, so a ticket issued by one listener resumes on any
+// other. With a seed file the keys are derived from it and reloaded
+// periodically, which also shares them across processes and hosts pointed at
+// the same file; without one the manager generates random keys and rotates
+// them itself.
+type SessionTicketManager struct {
+	mu      sync.Mutex
+	configs []*tls.Config
+	keys    [][32]byte
+}
+
+// NewSessionTicketManager creates a manager and starts the background key
+// rotation: periodic seed file reloads when one is configured, local random
+// key rotation otherwise (also the fallback when the seed file cannot be
+// read, so listeners never end up with independent per-config keys).
+func NewSessionTicketManager(keyConfig *SessionTicketKeysConfig) *SessionTicketManager {
+	m := &SessionTicketManager{}
+	if keyConfig.SeedFile != "" {
+		err := m.loadSeedFile(keyConfig.SeedFile)
+		if err == nil {
+			glog.Infof(
+				"Setting ticker to reload seed file %s every %d seconds.",
+				keyConfig.SeedFile,
+				keyConfig.SeedFileReloadInterval,
+			)
+			go m.reloadSeedFileLoop(
+				keyConfig.SeedFile,
+				time.Duration(keyConfig.SeedFileReloadInterval)*time.Second,
+			)
+			return m
+		}
+		glog.Errorf(
+			"Failed to load session tickets: %s. Falling back to locally generated keys",
+			err,
+		)
+	}
+	m.rotateLocal()
+	go m.rotateLocalLoop()
+	return m
+}
+
+// Attach registers a config with the manager and gives it the current keys
+func (m *SessionTicketManager) Attach(config *tls.Config) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.configs = append(m.configs, config)
+	if len(m.keys) > 0 {
+		config.SetSessionTicketKeys(m.keys)
+	}
+}
+
+// setKeysLocked stores the keys and pushes them to every attached config.
+// The caller must hold m.mu.
+func (m *SessionTicketManager) setKeysLocked(keys [][32]byte) {
+	m.keys = keys
+	for _, config := range m.configs {
+		config.SetSessionTicketKeys(keys)
+	}
+}
+
+func (m *SessionTicketManager) loadSeedFile(seedfile string) error {
 	seedReader, err := os.Open(seedfile)
 	if err != nil {
 		return fmt.Errorf("could not load seed file %q", seedfile)
@@ -44,10 +117,48 @@ func loadSessionTicketFromFile(config *tls.Config, seedfile string) error {
 		return fmt.Errorf("could not load TLS seeds from %s", seedfile)
 	}
 
-	config.SetSessionTicketKeys(seeds)
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.setKeysLocked(seeds)
 	return nil
 }
 
+func (m *SessionTicketManager) reloadSeedFileLoop(seedfile string, interval time.Duration) {
+	if interval <= 0 {
+		interval = time.Hour
+	}
+	ticker := time.NewTicker(interval)
+	for range ticker.C {
+		if err := m.loadSeedFile(seedfile); err != nil {
+			glog.Errorf("Failed to load session tickets: %s", err)
+		}
+	}
+}
+
+// rotateLocal prepends a fresh random key and drops the oldest one
+func (m *SessionTicketManager) rotateLocal() {
+	var key [32]byte
+	if _, err := rand.Read(key[:]); err != nil {
+		glog.Errorf("Failed to generate a session ticket key: %s", err)
+		return
+	}
+
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	keys := append([][32]byte{key}, m.keys...)
+	if len(keys) > sessionTicketKeyCount {
+		keys = keys[:sessionTicketKeyCount]
+	}
+	m.setKeysLocked(keys)
+}
+
+func (m *SessionTicketManager) rotateLocalLoop() {
+	ticker := time.NewTicker(sessionTicketRotationInterval)
+	for range ticker.C {
+		m.rotateLocal()
+	}
+}
+
 func loadSessionTicketKeys(reader io.Reader) (keys [][32]byte, err error) {
 	var (
 		t struct {
@@ -80,61 +191,28 @@ func loadSessionTicketKeys(reader io.Reader) (keys [][32]byte, err error) {
 	return
 }
 
-func initSessionTicketKeys(config *tls.Config, keyConfig *SessionTicketKeysConfig) {
-	if keyConfig.SeedFile != "" {
-		err := loadSessionTicketFromFile(config, keyConfig.SeedFile)
-		if err != nil {
-			glog.Errorf(
-				"Failed to load session tickets: %s. Skipping periodic reload ticker",
-				err,
-			)
-			return
-		}
-		glog.Infof(
-			"Setting ticker to reload seed file %s every %d seconds.",
-			keyConfig.SeedFile,
-			keyConfig.SeedFileReloadInterval,
-		)
-		ticker := time.NewTicker(
-			time.Duration(keyConfig.SeedFileReloadInterval) * time.Second,
-		)
-		quit := make(chan struct{})
-		go func() {
-			for {
-				select {
-				case <-ticker.C:
-					err := loadSessionTicketFromFile(config, keyConfig.SeedFile)
-					if err != nil {
-						glog.Errorf(
-							"Failed to load session tickets: %s",
-							err,
-						)
-					}
-				case <-quit:
-					ticker.Stop()
-					return
-				}
-			}
-		}()
-	} else {
-		glog.Infof("Skipping loading session ticket keys, no seed file provided.")
-	}
-}
-
 // InitTLSConfig loads keys and certs from a base TLSConfig into a new
-// TLSConfig.
+// TLSConfig. The session ticket keys are owned by a manager private to the
+// returned config; servers with several TLS listeners should use
+// InitTLSConfigWithSessionTickets so tickets resume across all of them.
 func InitTLSConfig(conf *TLSConfig) (*tls.Config, error) {
-	var err error
-	var certs []tls.Certificate
-	var cert tls.Certificate
-	cert, err = LoadTLSCertFromFile(conf)
-	certs = []tls.Certificate{cert}
+	return InitTLSConfigWithSessionTickets(conf, nil)
+}
+
+// InitTLSConfigWithSessionTickets is like InitTLSConfig, but attaches the
+// returned config to the given session ticket manager. A nil manager means a
+// new one, private to this config.
+func InitTLSConfigWithSessionTickets(conf *TLSConfig, tickets *SessionTicketManager) (*tls.Config, error) {
+	cert, err := LoadTLSCertFromFile(conf)
 	if err != nil {
 		return nil, err
 	}
-	config := tls.Config{
-		Certificates: certs,
+	config := &tls.Config{
+		Certificates: []tls.Certificate{cert},
+	}
+	if tickets == nil {
+		tickets = NewSessionTicketManager(&conf.SessionTicketKeys)
 	}
-	initSessionTicketKeys(&config, &conf.SessionTicketKeys)
-	return &config, nil
+	tickets.Attach(config)
+	return config, nil
 }
@@ -14,8 +14,12 @@ limitations under the License.
 package tlsconfig
 
 import (
+	"crypto/tls"
+	"io"
+	"net"
 	"os"
 	"testing"
+	"time"
 
 	"github.com/facebook/dns/dnsrocks/testaid"
 
@@ -70,3 +74,77 @@ func TestInitTLSConfigNoErrorOnInvalidResumptionTicket(t *testing.T) {
 	require.Nil(t, err)
 	require.NotNil(t, tlsconfig)
 }
+
+// handshakePair performs a TLS handshake over an in-memory pipe and reads one
+// byte of application data, which also delivers the session tickets sent by
+// the server after the TLS 1.3 handshake.
+func handshakePair(t *testing.T, serverConf, clientConf *tls.Config) *tls.Conn {
+	clientSide, serverSide := net.Pipe()
+	deadline := time.Now().Add(5 * time.Second)
+	require.Nil(t, clientSide.SetDeadline(deadline))
+	require.Nil(t, serverSide.SetDeadline(deadline))
+
+	srvErr := make(chan error, 1)
+	go func() {
+		srv := tls.Server(serverSide, serverConf)
+		if err := srv.Handshake(); err != nil {
+			srvErr <- err
+			return
+		}
+		_, err := srv.Write([]byte{0})
+		srvErr <- err
+	}()
+
+	client := tls.Client(clientSide, clientConf)
+	_, err := io.ReadFull(client, make([]byte, 1))
+	require.Nil(t, err)
+	require.Nil(t, <-srvErr)
+	return client
+}
+
+// TestSessionTicketManagerSharesKeysAcrossConfigs tests that a session ticket
+// issued through one config attached to a manager resumes on another one, as
+// happens when a resolver reconnects to a different listener
+func TestSessionTicketManagerSharesKeysAcrossConfigs(t *testing.T) {
+	certfile := testaid.MkTestCert(t)
+	defer os.Remove(certfile)
+	base := makeTLSConfig(certfile, SessionTicketKeysConfig{})
+
+	tickets := NewSessionTicketManager(&base.SessionTicketKeys)
+	conf1, err := InitTLSConfigWithSessionTickets(base, tickets)
+	require.Nil(t, err)
+	conf2, err := InitTLSConfigWithSessionTickets(base, tickets)
+	require.Nil(t, err)
+
+	clientConf := &tls.Config{
+		InsecureSkipVerify: true,
+		ServerName:         "localhost",
+		ClientSessionCache: tls.NewLRUClientSessionCache(8),
+	}
+
+	c1 := handshakePair(t, conf1, clientConf)
+	require.False(t, c1.ConnectionState().DidResume)
+	c1.Close()
+
+	c2 := handshakePair(t, conf2, clientConf)
+	require.True(t, c2.ConnectionState().DidResume)
+	c2.Close()
+}
+
+// TestSessionTicketManagerRotatesLocalKeys tests the locally generated keys
+// used when no seed file is configured
+func TestSessionTicketManagerRotatesLocalKeys(t *testing.T) {
+	m := NewSessionTicketManager(&SessionTicketKeysConfig{})
+	require.Equal(t, 1, len(m.keys))
+	first := m.keys[0]
+
+	m.rotateLocal()
+	m.rotateLocal()
+	require.Equal(t, 3, len(m.keys))
+	// the oldest key is still accepted for resumption
+	require.Equal(t, first, m.keys[2])
+
+	m.rotateLocal()
+	require.Equal(t, 3, len(m.keys))
+	require.NotContains(t, m.keys, first)
+}
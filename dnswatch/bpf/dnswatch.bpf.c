@@ -42,6 +42,35 @@ struct {
   __uint(max_entries, 1 << 24);
 } dnswatch_kprobe_output_events SEC(".maps");
 
+// dnswatch_kprobe_sample_rate holds the sampling rate for the detailed
+// per-event stream: submit roughly 1 in N events to the ringbuf, 0 or 1
+// submits every event. Userspace sets it once after load.
+struct {
+  __uint(type, BPF_MAP_TYPE_ARRAY);
+  __uint(max_entries, 1);
+  __type(key, u32);
+  __type(value, u32);
+} dnswatch_kprobe_sample_rate SEC(".maps");
+
+struct dnswatch_kprobe_agg_key {
+  u32 tgid;
+  char fn_id;
+};
+
+struct dnswatch_kprobe_agg_val {
+  u64 calls;
+};
+
+// dnswatch_kprobe_agg aggregates per (process, function) call counters in
+// the kernel. Userspace scrapes (and deletes) the entries periodically, so
+// the counts stay exact even when the detailed event stream is sampled.
+struct {
+  __uint(type, BPF_MAP_TYPE_HASH);
+  __uint(max_entries, HASHMAP_SIZE);
+  __type(key, struct dnswatch_kprobe_agg_key);
+  __type(value, struct dnswatch_kprobe_agg_val);
+} dnswatch_kprobe_agg SEC(".maps");
+
 // sendmsg_solver populates the dnswatch_kprobe_event_data struct for each
 // callback.
 static int
@@ -57,6 +86,29 @@ sendmsg_solver(struct pt_regs* ctx, char fn_id, u16 dport, u16 sport) {
   u32 __tgid = __pid_tgid >> 32;
   u32 __pid = __pid_tgid;
 
+  // always count the call in the aggregation map, the zero initializer also
+  // clears the struct padding so map keys hash consistently
+  struct dnswatch_kprobe_agg_key agg_key = {};
+  agg_key.tgid = __tgid;
+  agg_key.fn_id = fn_id;
+  struct dnswatch_kprobe_agg_val* agg_val =
+      bpf_map_lookup_elem(&dnswatch_kprobe_agg, &agg_key);
+  if (agg_val) {
+    __sync_fetch_and_add(&agg_val->calls, 1);
+  } else {
+    struct dnswatch_kprobe_agg_val agg_init = {.calls = 1};
+    bpf_map_update_elem(&dnswatch_kprobe_agg, &agg_key, &agg_init, BPF_ANY);
+  }
+
+  // submit only 1 in sample_rate events to the detailed stream, so the
+  // ringbuf does not overflow on hosts doing very high QPS
+  u32 zero = 0;
+  u32* sample_rate = bpf_map_lookup_elem(&dnswatch_kprobe_sample_rate, &zero);
+  if (sample_rate && *sample_rate > 1 &&
+      bpf_get_prandom_u32() % *sample_rate != 0) {
+    return 0;
+  }
+
   struct dnswatch_kprobe_event_data* data = bpf_ringbuf_reserve(
       &dnswatch_kprobe_output_events,
       sizeof(struct dnswatch_kprobe_event_data),
@@ -38,6 +38,10 @@ func init() {
 	RootCmd.PersistentFlags().IntVar(&cfg.Port, "port", 53, "port number")
 	RootCmd.PersistentFlags().IntVar(&cfg.RingSizeMB, "ringsize", 10, "ring size (MB) used to store packets")
 	RootCmd.PersistentFlags().DurationVar(&cfg.CleanPeriod, "period", 3*time.Second, "monitoring timeframe before writing to csv or refreshing the screen")
+	RootCmd.PersistentFlags().IntVar(&cfg.SampleRate, "samplerate", 0, "submit only 1 in N probe events to the detailed stream, 0 or 1 submits all; per-process totals stay exact via in-kernel counters")
+	RootCmd.PersistentFlags().StringVar(&cfg.FilterQtype, "filter-qtype", "", "drop DNS packets whose question type differs, in kernel (e.g. A, AAAA, PTR)")
+	RootCmd.PersistentFlags().StringVar(&cfg.FilterRcode, "filter-rcode", "", "drop DNS responses whose response code differs, in kernel (e.g. NOERROR, NXDOMAIN); queries still pass")
+	RootCmd.PersistentFlags().StringVar(&cfg.FilterQname, "filter-qname", "", "drop DNS packets whose question name does not end with this suffix, in kernel (e.g. example.com)")
 }
 
 // ConfigureVerbosity configures log verbosity based on parsed flags. Needs to be called by any subcommand.
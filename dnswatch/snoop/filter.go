@@ -37,6 +37,9 @@ type Filter struct {
 	Interface  string
 	Debug      bool
 	RingSizeMB int
+	// Kernel holds the in-kernel DNS predicates. When any of them is set it
+	// replaces Rule with a program that also parses the DNS question.
+	Kernel *KernelFilter
 
 	tPacket *afpacket.TPacket
 }
@@ -99,6 +102,16 @@ func (f *Filter) Setup() error {
 		return fmt.Errorf("unable to create new TPacket object : %w", err)
 	}
 
+	if f.Kernel != nil && f.Kernel.Enabled() {
+		prog, err := f.Kernel.Program()
+		if err != nil {
+			return fmt.Errorf("unable to compile kernel DNS filter: %w", err)
+		}
+		if err := f.tPacket.SetBPF(prog); err != nil {
+			return fmt.Errorf("unable to set kernel DNS filter: %w", err)
+		}
+		return nil
+	}
 	if err := SetBPFFilter(f.tPacket, f.Rule, snapLen); err != nil {
 		return fmt.Errorf("unable to set BPF filter: %w", err)
 	}
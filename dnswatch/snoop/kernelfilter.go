@@ -0,0 +1,360 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package snoop
+
+import (
+	"fmt"
+	"strconv"
+	"strings"
+
+	mkdns "github.com/miekg/dns"
+	"golang.org/x/net/bpf"
+)
+
+const (
+	etherTypeIPv4 = 0x0800
+	etherTypeIPv6 = 0x86dd
+	protoTCP      = 6
+	protoUDP      = 17
+
+	// maxQnameLabels bounds the unrolled qname walk. Names with more labels
+	// are passed to userspace instead of being wrongly dropped.
+	maxQnameLabels = 32
+
+	// maxQnameSuffixLen bounds the wire format of the qname filter so every
+	// failure jump stays within the 255 instruction reach of classic BPF.
+	maxQnameSuffixLen = 64
+)
+
+// KernelFilter compiles DNS filter predicates into the classic BPF program
+// attached to the AF_PACKET socket, so packets which cannot match are dropped
+// in the kernel instead of crossing the ring buffer only to be discarded by
+// the userspace decoder.
+//
+// The generated program parses plain Ethernet + IPv4/IPv6 + UDP, locates the
+// DNS header and walks the first question. Whatever it cannot evaluate is
+// passed to userspace rather than dropped: DNS over TCP (stream framing),
+// IPv6 extension headers, names using compression pointers or more than
+// maxQnameLabels labels.
+type KernelFilter struct {
+	// Port is the DNS port, same as Config.Port
+	Port int
+	// QType drops packets whose first question type differs.
+	// Accepts a type mnemonic ("A", "AAAA", "PTR", ...) or a numeric value.
+	QType string
+	// Rcode drops responses whose response code differs. Accepts an rcode
+	// mnemonic ("NOERROR", "NXDOMAIN", ...) or a numeric value. Queries
+	// carry no response code and always pass.
+	Rcode string
+	// QnameSuffix drops packets whose first question name does not end with
+	// this suffix. The match is case insensitive and anchored on label
+	// boundaries, e.g. "example.com" matches "a.example.com" but not
+	// "badexample.com".
+	QnameSuffix string
+}
+
+// Enabled is true if any filter predicate is set
+func (k *KernelFilter) Enabled() bool {
+	return k.QType != "" || k.Rcode != "" || k.QnameSuffix != ""
+}
+
+// Instructions assembles the filter into symbolic classic BPF
+func (k *KernelFilter) Instructions() ([]bpf.Instruction, error) {
+	var qtype uint16
+	var rcode int
+	var suffix []byte
+	var err error
+	if k.QType != "" {
+		if qtype, err = parseQtypeFilter(k.QType); err != nil {
+			return nil, err
+		}
+	}
+	if k.Rcode != "" {
+		if rcode, err = parseRcodeFilter(k.Rcode); err != nil {
+			return nil, err
+		}
+	}
+	if k.QnameSuffix != "" {
+		if suffix, err = encodeQnameSuffix(k.QnameSuffix); err != nil {
+			return nil, err
+		}
+	}
+	needQname := k.QType != "" || len(suffix) > 0
+	port := uint32(k.Port)
+
+	a := newCbpfAsm()
+
+	// L2/L3/L4 parse. DNS over TCP is accepted as is: it is length prefixed
+	// and can be segmented, so it is left to the userspace decoder.
+	a.op(bpf.LoadAbsolute{Off: 12, Size: 2}) // EtherType
+	a.jmp(bpf.JumpEqual, etherTypeIPv4, "ipv4", "")
+	a.jmp(bpf.JumpEqual, etherTypeIPv6, "ipv6", "drop0")
+
+	a.label("ipv4")
+	a.op(bpf.LoadAbsolute{Off: 23, Size: 1}) // protocol
+	a.jmp(bpf.JumpEqual, protoTCP, "accept0", "")
+	a.jmp(bpf.JumpEqual, protoUDP, "", "drop0")
+	a.op(bpf.LoadAbsolute{Off: 20, Size: 2}) // flags + fragment offset
+	a.jmp(bpf.JumpBitsSet, 0x1fff, "drop0", "")
+	a.op(bpf.LoadMemShift{Off: 14})          // X = IPv4 header length
+	a.op(bpf.LoadIndirect{Off: 14, Size: 2}) // UDP source port
+	a.jmp(bpf.JumpEqual, port, "ipv4dns", "")
+	a.op(bpf.LoadIndirect{Off: 16, Size: 2}) // UDP destination port
+	a.jmp(bpf.JumpEqual, port, "ipv4dns", "drop0")
+	a.label("ipv4dns")
+	a.op(bpf.TXA{})
+	a.op(bpf.ALUOpConstant{Op: bpf.ALUOpAdd, Val: 14 + 8}) // A = DNS header offset
+	a.ja("dns")
+
+	a.label("ipv6")
+	a.op(bpf.LoadAbsolute{Off: 20, Size: 1}) // next header, extension headers not parsed
+	a.jmp(bpf.JumpEqual, protoTCP, "accept0", "")
+	a.jmp(bpf.JumpEqual, protoUDP, "", "drop0")
+	a.op(bpf.LoadAbsolute{Off: 54, Size: 2}) // UDP source port
+	a.jmp(bpf.JumpEqual, port, "ipv6dns", "")
+	a.op(bpf.LoadAbsolute{Off: 56, Size: 2}) // UDP destination port
+	a.jmp(bpf.JumpEqual, port, "ipv6dns", "drop0")
+	a.label("ipv6dns")
+	a.op(bpf.LoadConstant{Dst: bpf.RegA, Val: 14 + 40 + 8}) // A = DNS header offset
+	a.ja("dns")
+
+	// local return islands: classic BPF only jumps forward and at most 255
+	// instructions, too short to reach the shared exits past the qname walk
+	a.label("drop0")
+	a.op(bpf.RetConstant{Val: 0})
+	a.label("accept0")
+	a.op(bpf.RetConstant{Val: snapLen})
+
+	a.label("dns")
+	a.op(bpf.StoreScratch{Src: bpf.RegA, N: 0}) // M[0] = DNS header offset
+	a.op(bpf.TAX{})                             // X = DNS header offset
+	if k.Rcode != "" {
+		rcodeDrop := "drop"
+		if needQname {
+			rcodeDrop = "dropdns"
+		}
+		a.op(bpf.LoadIndirect{Off: 2, Size: 1}) // flags byte holding QR
+		a.jmp(bpf.JumpBitsSet, 0x80, "", "rcodeok")
+		a.op(bpf.LoadIndirect{Off: 3, Size: 1})
+		a.op(bpf.ALUOpConstant{Op: bpf.ALUOpAnd, Val: 0x0f})
+		a.jmp(bpf.JumpNotEqual, uint32(rcode), rcodeDrop, "")
+		a.label("rcodeok")
+	}
+	if !needQname {
+		a.op(bpf.RetConstant{Val: snapLen})
+		a.label("drop")
+		a.op(bpf.RetConstant{Val: 0})
+		return a.assemble()
+	}
+
+	a.op(bpf.LoadIndirect{Off: 4, Size: 2}) // QDCOUNT
+	a.jmp(bpf.JumpEqual, 0, "dropdns", "")
+	a.op(bpf.LoadScratch{Dst: bpf.RegA, N: 0})
+	a.op(bpf.ALUOpConstant{Op: bpf.ALUOpAdd, Val: 12})
+	a.op(bpf.StoreScratch{Src: bpf.RegA, N: 1}) // M[1] = first question name
+	a.op(bpf.TAX{})
+	a.ja("walk")
+	a.label("dropdns")
+	a.op(bpf.RetConstant{Val: 0})
+
+	// walk the name label by label until the empty root label. The loop is
+	// unrolled because classic BPF has no backward jumps.
+	a.label("walk")
+	for i := 0; i < maxQnameLabels; i++ {
+		a.op(bpf.LoadIndirect{Off: 0, Size: 1}) // label length
+		a.jmp(bpf.JumpEqual, 0, "qnameend", "")
+		a.jmp(bpf.JumpBitsSet, 0xc0, "walkout", "") // compression pointer
+		a.op(bpf.ALUOpX{Op: bpf.ALUOpAdd})
+		a.op(bpf.ALUOpConstant{Op: bpf.ALUOpAdd, Val: 1})
+		a.op(bpf.TAX{})
+	}
+	a.label("walkout") // compressed or very long name, let userspace decide
+	a.op(bpf.RetConstant{Val: snapLen})
+
+	a.label("qnameend") // X = offset of the root label
+	if k.QType != "" {
+		a.op(bpf.LoadIndirect{Off: 1, Size: 2}) // qtype follows the root label
+		a.jmp(bpf.JumpNotEqual, uint32(qtype), "drop", "")
+	}
+	if len(suffix) > 0 {
+		a.op(bpf.TXA{})
+		a.op(bpf.ALUOpConstant{Op: bpf.ALUOpSub, Val: uint32(len(suffix))})
+		a.op(bpf.LoadScratch{Dst: bpf.RegX, N: 1})
+		a.jmpX(bpf.JumpLessThan, "drop", "") // name shorter than the suffix
+		a.op(bpf.TAX{})                      // X = where the suffix must start
+		for i, b := range suffix {
+			a.op(bpf.LoadIndirect{Off: uint32(i), Size: 1})
+			a.op(bpf.ALUOpConstant{Op: bpf.ALUOpOr, Val: 0x20}) // ASCII lowercase
+			a.jmp(bpf.JumpNotEqual, uint32(b)|0x20, "drop", "")
+		}
+	}
+	a.op(bpf.RetConstant{Val: snapLen})
+	a.label("drop")
+	a.op(bpf.RetConstant{Val: 0})
+	return a.assemble()
+}
+
+// Program assembles the filter into raw instructions ready for SetBPF
+func (k *KernelFilter) Program() ([]bpf.RawInstruction, error) {
+	insns, err := k.Instructions()
+	if err != nil {
+		return nil, err
+	}
+	return bpf.Assemble(insns)
+}
+
+// parseQtypeFilter accepts a type mnemonic ("A", "AAAA", ...) or a numeric value
+func parseQtypeFilter(s string) (uint16, error) {
+	if t, ok := mkdns.StringToType[strings.ToUpper(s)]; ok {
+		return t, nil
+	}
+	if n, err := strconv.Atoi(s); err == nil && n >= 0 && n < 1<<16 {
+		return uint16(n), nil
+	}
+	return 0, fmt.Errorf("unknown qtype %q in kernel filter", s)
+}
+
+// parseRcodeFilter accepts an rcode mnemonic ("NOERROR", "NXDOMAIN", ...) or a
+// numeric value. Only header rcodes fit in 4 bits, extended rcodes live in OPT.
+func parseRcodeFilter(s string) (int, error) {
+	if r, ok := mkdns.StringToRcode[strings.ToUpper(s)]; ok && r <= 0x0f {
+		return r, nil
+	}
+	if n, err := strconv.Atoi(s); err == nil && n >= 0 && n <= 0x0f {
+		return n, nil
+	}
+	return 0, fmt.Errorf("unknown rcode %q in kernel filter", s)
+}
+
+// encodeQnameSuffix converts a dotted name into its lowercased wire format,
+// e.g. "Facebook.com" -> \x08facebook\x03com
+func encodeQnameSuffix(name string) ([]byte, error) {
+	name = strings.TrimSuffix(strings.ToLower(strings.TrimSpace(name)), ".")
+	if name == "" {
+		return nil, fmt.Errorf("empty qname in kernel filter")
+	}
+	var enc []byte
+	for _, label := range strings.Split(name, ".") {
+		if label == "" || len(label) > 63 {
+			return nil, fmt.Errorf("invalid label %q in kernel filter qname", label)
+		}
+		enc = append(enc, byte(len(label)))
+		enc = append(enc, label...)
+	}
+	if len(enc) > maxQnameSuffixLen {
+		return nil, fmt.Errorf("qname suffix %q longer than %d bytes on the wire", name, maxQnameSuffixLen)
+	}
+	return enc, nil
+}
+
+// cbpfAsm assembles a classic BPF program with named jump targets, resolved
+// into relative skips in a second pass. Classic BPF only jumps forward, so a
+// target must be declared after every jump that uses it.
+type cbpfAsm struct {
+	insns  []cbpfInsn
+	labels map[string]int
+	err    error
+}
+
+// cbpfInsn is either a plain instruction or a jump with symbolic targets.
+// An empty target means fall through.
+type cbpfInsn struct {
+	ins bpf.Instruction
+
+	jump   bool
+	useX   bool
+	cond   bpf.JumpTest
+	val    uint32
+	jt, jf string
+
+	jaTarget string
+}
+
+func newCbpfAsm() *cbpfAsm {
+	return &cbpfAsm{labels: make(map[string]int)}
+}
+
+func (a *cbpfAsm) op(ins bpf.Instruction) {
+	a.insns = append(a.insns, cbpfInsn{ins: ins})
+}
+
+func (a *cbpfAsm) jmp(cond bpf.JumpTest, val uint32, jt, jf string) {
+	a.insns = append(a.insns, cbpfInsn{jump: true, cond: cond, val: val, jt: jt, jf: jf})
+}
+
+func (a *cbpfAsm) jmpX(cond bpf.JumpTest, jt, jf string) {
+	a.insns = append(a.insns, cbpfInsn{jump: true, useX: true, cond: cond, jt: jt, jf: jf})
+}
+
+func (a *cbpfAsm) ja(target string) {
+	a.insns = append(a.insns, cbpfInsn{jaTarget: target})
+}
+
+func (a *cbpfAsm) label(name string) {
+	if _, ok := a.labels[name]; ok {
+		a.err = fmt.Errorf("duplicate label %q", name)
+		return
+	}
+	a.labels[name] = len(a.insns)
+}
+
+// skip resolves a label into the number of instructions to jump over
+func (a *cbpfAsm) skip(from int, label string) (int, error) {
+	if label == "" {
+		return 0, nil
+	}
+	to, ok := a.labels[label]
+	if !ok {
+		return 0, fmt.Errorf("undefined jump target %q", label)
+	}
+	s := to - from - 1
+	if s < 0 || s > 255 {
+		return 0, fmt.Errorf("jump to %q out of range: %d", label, s)
+	}
+	return s, nil
+}
+
+func (a *cbpfAsm) assemble() ([]bpf.Instruction, error) {
+	if a.err != nil {
+		return nil, a.err
+	}
+	out := make([]bpf.Instruction, 0, len(a.insns))
+	for i, in := range a.insns {
+		switch {
+		case in.jaTarget != "":
+			s, err := a.skip(i, in.jaTarget)
+			if err != nil {
+				return nil, err
+			}
+			out = append(out, bpf.Jump{Skip: uint32(s)})
+		case in.jump:
+			jt, err := a.skip(i, in.jt)
+			if err != nil {
+				return nil, err
+			}
+			jf, err := a.skip(i, in.jf)
+			if err != nil {
+				return nil, err
+			}
+			if in.useX {
+				out = append(out, bpf.JumpIfX{Cond: in.cond, SkipTrue: uint8(jt), SkipFalse: uint8(jf)})
+			} else {
+				out = append(out, bpf.JumpIf{Cond: in.cond, Val: in.val, SkipTrue: uint8(jt), SkipFalse: uint8(jf)})
+			}
+		default:
+			out = append(out, in.ins)
+		}
+	}
+	return out, nil
+}
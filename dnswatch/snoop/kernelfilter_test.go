@@ -0,0 +1,199 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package snoop
+
+import (
+	"net"
+	"testing"
+
+	"github.com/google/gopacket"
+	"github.com/google/gopacket/layers"
+	"github.com/stretchr/testify/require"
+	"golang.org/x/net/bpf"
+)
+
+// testPacket describes a synthetic DNS packet serialized for the filter tests
+type testPacket struct {
+	qname   string
+	qtype   layers.DNSType
+	qr      bool
+	rcode   layers.DNSResponseCode
+	srcPort layers.UDPPort
+	dstPort layers.UDPPort
+	ipv6    bool
+}
+
+func (p *testPacket) serialize(t *testing.T) []byte {
+	eth := &layers.Ethernet{
+		SrcMAC:       net.HardwareAddr{2, 0, 0, 0, 0, 1},
+		DstMAC:       net.HardwareAddr{2, 0, 0, 0, 0, 2},
+		EthernetType: layers.EthernetTypeIPv4,
+	}
+	udp := &layers.UDP{SrcPort: p.srcPort, DstPort: p.dstPort}
+	dns := &layers.DNS{
+		ID:           4242,
+		QR:           p.qr,
+		ResponseCode: p.rcode,
+		Questions: []layers.DNSQuestion{{
+			Name:  []byte(p.qname),
+			Type:  p.qtype,
+			Class: layers.DNSClassIN,
+		}},
+	}
+	buf := gopacket.NewSerializeBuffer()
+	opts := gopacket.SerializeOptions{FixLengths: true}
+	var err error
+	if p.ipv6 {
+		eth.EthernetType = layers.EthernetTypeIPv6
+		ip := &layers.IPv6{
+			Version:    6,
+			NextHeader: layers.IPProtocolUDP,
+			HopLimit:   64,
+			SrcIP:      net.ParseIP("::1"),
+			DstIP:      net.ParseIP("::2"),
+		}
+		err = gopacket.SerializeLayers(buf, opts, eth, ip, udp, dns)
+	} else {
+		ip := &layers.IPv4{
+			Version:  4,
+			TTL:      64,
+			Protocol: layers.IPProtocolUDP,
+			SrcIP:    net.IP{127, 0, 0, 1},
+			DstIP:    net.IP{127, 0, 0, 2},
+		}
+		err = gopacket.SerializeLayers(buf, opts, eth, ip, udp, dns)
+	}
+	require.Nil(t, err)
+	return buf.Bytes()
+}
+
+// runKernelFilter runs the generated classic BPF program in the x/net/bpf VM
+// and reports whether the packet is accepted
+func runKernelFilter(t *testing.T, k *KernelFilter, pkt []byte) bool {
+	insns, err := k.Instructions()
+	require.Nil(t, err)
+	vm, err := bpf.NewVM(insns)
+	require.Nil(t, err)
+	n, err := vm.Run(pkt)
+	require.Nil(t, err)
+	return n > 0
+}
+
+func TestKernelFilterQtype(t *testing.T) {
+	k := &KernelFilter{Port: 53, QType: "A"}
+	require.True(t, k.Enabled())
+
+	q := &testPacket{qname: "test.example.com", qtype: layers.DNSTypeA, srcPort: 1234, dstPort: 53}
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+
+	q.qtype = layers.DNSTypeAAAA
+	require.False(t, runKernelFilter(t, k, q.serialize(t)))
+
+	// numeric qtype, 28 is AAAA
+	k = &KernelFilter{Port: 53, QType: "28"}
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+}
+
+func TestKernelFilterQnameSuffix(t *testing.T) {
+	k := &KernelFilter{Port: 53, QnameSuffix: "example.com"}
+
+	q := &testPacket{qname: "foo.example.com", qtype: layers.DNSTypeA, srcPort: 1234, dstPort: 53}
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+
+	// exact match and 0x20 mixed case still pass
+	q.qname = "example.com"
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+	q.qname = "foo.ExAmPlE.CoM"
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+
+	// responses carry the question section too
+	q.qr = true
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+	q.qr = false
+
+	q.qname = "other.org"
+	require.False(t, runKernelFilter(t, k, q.serialize(t)))
+
+	// suffix match is anchored on label boundaries
+	k = &KernelFilter{Port: 53, QnameSuffix: "ample.com"}
+	q.qname = "example.com"
+	require.False(t, runKernelFilter(t, k, q.serialize(t)))
+}
+
+func TestKernelFilterRcode(t *testing.T) {
+	k := &KernelFilter{Port: 53, Rcode: "NXDOMAIN"}
+
+	r := &testPacket{qname: "foo.example.com", qtype: layers.DNSTypeA, qr: true,
+		rcode: layers.DNSResponseCodeNXDomain, srcPort: 53, dstPort: 1234}
+	require.True(t, runKernelFilter(t, k, r.serialize(t)))
+
+	r.rcode = layers.DNSResponseCodeNoErr
+	require.False(t, runKernelFilter(t, k, r.serialize(t)))
+
+	// queries have no rcode and always pass
+	r.qr = false
+	require.True(t, runKernelFilter(t, k, r.serialize(t)))
+}
+
+func TestKernelFilterTransport(t *testing.T) {
+	k := &KernelFilter{Port: 53, QType: "A"}
+
+	// other ports are dropped no matter the payload
+	q := &testPacket{qname: "foo.example.com", qtype: layers.DNSTypeA, srcPort: 1234, dstPort: 5353}
+	require.False(t, runKernelFilter(t, k, q.serialize(t)))
+
+	// IPv6 is parsed the same way
+	q = &testPacket{qname: "foo.example.com", qtype: layers.DNSTypeA, srcPort: 1234, dstPort: 53, ipv6: true}
+	require.True(t, runKernelFilter(t, k, q.serialize(t)))
+	q.qtype = layers.DNSTypeAAAA
+	require.False(t, runKernelFilter(t, k, q.serialize(t)))
+
+	// DNS over TCP cannot be parsed statelessly and is left to userspace
+	eth := &layers.Ethernet{
+		SrcMAC:       net.HardwareAddr{2, 0, 0, 0, 0, 1},
+		DstMAC:       net.HardwareAddr{2, 0, 0, 0, 0, 2},
+		EthernetType: layers.EthernetTypeIPv4,
+	}
+	ip := &layers.IPv4{
+		Version:  4,
+		TTL:      64,
+		Protocol: layers.IPProtocolTCP,
+		SrcIP:    net.IP{127, 0, 0, 1},
+		DstIP:    net.IP{127, 0, 0, 2},
+	}
+	tcp := &layers.TCP{SrcPort: 1234, DstPort: 53}
+	require.Nil(t, tcp.SetNetworkLayerForChecksum(ip))
+	buf := gopacket.NewSerializeBuffer()
+	err := gopacket.SerializeLayers(buf, gopacket.SerializeOptions{FixLengths: true, ComputeChecksums: true}, eth, ip, tcp)
+	require.Nil(t, err)
+	require.True(t, runKernelFilter(t, k, buf.Bytes()))
+}
+
+func TestKernelFilterValidation(t *testing.T) {
+	k := &KernelFilter{}
+	require.False(t, k.Enabled())
+
+	_, err := (&KernelFilter{Port: 53, QType: "NOSUCHTYPE"}).Instructions()
+	require.NotNil(t, err)
+
+	_, err = (&KernelFilter{Port: 53, Rcode: "NOSUCHRCODE"}).Instructions()
+	require.NotNil(t, err)
+
+	_, err = (&KernelFilter{Port: 53, QnameSuffix: "bad..label"}).Instructions()
+	require.NotNil(t, err)
+
+	enc, err := encodeQnameSuffix("Facebook.com.")
+	require.Nil(t, err)
+	require.Equal(t, []byte("\x08facebook\x03com"), enc)
+}
@@ -24,6 +24,7 @@ import (
 	"os"
 	"os/signal"
 	"syscall"
+	"time"
 	"unsafe"
 
 	"github.com/aquasecurity/libbpfgo"
@@ -106,6 +107,29 @@ type EnhancedProbeData struct {
 	FnID uint8
 }
 
+// ProbeAggData is one row of the in-kernel aggregation map: how often a
+// process called one of the probed functions since the last scrape
+type ProbeAggData struct {
+	// Tgid is the thread group id
+	Tgid uint32
+	// FnID is the identifier of the function
+	FnID uint8
+	// Calls is the number of calls counted in the kernel
+	Calls uint64
+}
+
+// probeAggKey mirrors struct dnswatch_kprobe_agg_key in the BPF program
+type probeAggKey struct {
+	Tgid uint32
+	FnID uint8
+	_    [3]uint8
+}
+
+// ProbeAggDTO carries one periodic scrape of the in-kernel aggregation map
+type ProbeAggDTO struct {
+	Rows []ProbeAggData
+}
+
 // Probe is the BPF handler which attaches kprobes to kernel functions
 // It receives kernel data each time one of these functions is called
 type Probe struct {
@@ -113,6 +137,15 @@ type Probe struct {
 
 	Port  int
 	Debug bool
+
+	// SampleRate submits only 1 in SampleRate events to the detailed
+	// per-event stream; 0 or 1 submits every event. The in-kernel counters
+	// stay exact either way.
+	SampleRate int
+	// AggPeriod is how often the in-kernel aggregation map is scraped
+	AggPeriod time.Duration
+	// AggCh receives the periodic scrapes when set
+	AggCh chan<- *ProbeAggDTO
 }
 
 // cleanCmdline used to clean cmdline from kernel
@@ -201,6 +234,48 @@ func (p *Probe) Run(ch chan<- *ProbeDTO) error {
 	}
 	defer bpfModule.Close()
 
+	if p.SampleRate > 1 {
+		sampleMap, err := bpfModule.GetMap("dnswatch_kprobe_sample_rate")
+		if err != nil {
+			return fmt.Errorf("unable to get sample rate map: %w", err)
+		}
+		key := uint32(0)
+		rate := uint32(p.SampleRate)
+		if err := sampleMap.Update(unsafe.Pointer(&key), unsafe.Pointer(&rate)); err != nil {
+			return fmt.Errorf("unable to set sample rate: %w", err)
+		}
+		log.Infof("sampling 1 in %d probe events", p.SampleRate)
+	}
+
+	// scrape (and reset) the in-kernel aggregation counters periodically
+	aggDone := make(chan struct{})
+	defer close(aggDone)
+	if p.AggCh != nil && p.AggPeriod > 0 {
+		aggMap, err := bpfModule.GetMap("dnswatch_kprobe_agg")
+		if err != nil {
+			return fmt.Errorf("unable to get aggregation map: %w", err)
+		}
+		go func() {
+			ticker := time.NewTicker(p.AggPeriod)
+			defer ticker.Stop()
+			for {
+				select {
+				case <-ticker.C:
+					rows, err := scrapeAggMap(aggMap)
+					if err != nil {
+						if p.Debug {
+							log.Printf("unable to scrape aggregation map: %v", err)
+						}
+						continue
+					}
+					p.AggCh <- &ProbeAggDTO{Rows: rows}
+				case <-aggDone:
+					return
+				}
+			}
+		}()
+	}
+
 	// Setup for capturing events. Table is used to store events from probe
 	// and channel is used to get the table information
 
@@ -271,7 +346,46 @@ func (p *Probe) Run(ch chan<- *ProbeDTO) error {
 	return nil
 }
 
+// scrapeAggMap drains the in-kernel aggregation map: every entry is read
+// and deleted, so the next scrape returns counts for the next interval only
+func scrapeAggMap(aggMap *libbpfgo.BPFMap) ([]ProbeAggData, error) {
+	keys := make([][]byte, 0)
+	iter := aggMap.Iterator()
+	for iter.Next() {
+		key := make([]byte, len(iter.Key()))
+		copy(key, iter.Key())
+		keys = append(keys, key)
+	}
+	if err := iter.Err(); err != nil {
+		return nil, fmt.Errorf("unable to iterate aggregation map: %w", err)
+	}
+	rows := make([]ProbeAggData, 0, len(keys))
+	for _, key := range keys {
+		value, err := aggMap.GetValue(unsafe.Pointer(&key[0]))
+		if err != nil {
+			// the entry may have been recreated since the iteration
+			continue
+		}
+		var aggKey probeAggKey
+		if err := binary.Read(bytes.NewBuffer(key), determineHostByteOrder(), &aggKey); err != nil {
+			return nil, fmt.Errorf("unable to read aggregation key: %w", err)
+		}
+		rows = append(rows, ProbeAggData{
+			Tgid:  aggKey.Tgid,
+			FnID:  aggKey.FnID,
+			Calls: determineHostByteOrder().Uint64(value),
+		})
+		// a failed delete is not fatal, at worst these calls are counted
+		// again on the next scrape
+		_ = aggMap.DeleteKey(unsafe.Pointer(&key[0]))
+	}
+	return rows, nil
+}
+
 func getProcComm(pid uint32) ([commLength]byte, error) {
+	if pidToCommCache == nil {
+		pidToCommCache = make(map[uint32][commLength]byte)
+	}
 	cachedComm, found := pidToCommCache[pid]
 	// If the key exists
 	if found {
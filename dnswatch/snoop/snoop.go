@@ -18,6 +18,7 @@ import (
 	"net"
 	"os"
 	"regexp"
+	"strings"
 	"sync"
 	"time"
 
@@ -58,7 +59,11 @@ type Config struct {
 	Interface      string
 	Port           int
 	FilterDebug    bool
+	FilterQtype    string
+	FilterRcode    string
+	FilterQname    string
 	ProbeDebug     bool
+	SampleRate     int
 	RingSizeMB     int
 	CleanPeriod    time.Duration
 	Fields         string
@@ -90,9 +95,11 @@ func Run(c *Config) error {
 	}
 
 	bpfProbe := &Probe{
-		Port:      c.Port,
-		Debug:     c.ProbeDebug,
-		setupDone: make(chan bool, 1),
+		Port:       c.Port,
+		Debug:      c.ProbeDebug,
+		SampleRate: c.SampleRate,
+		AggPeriod:  c.CleanPeriod,
+		setupDone:  make(chan bool, 1),
 	}
 
 	bpfFilter := &Filter{
@@ -100,6 +107,12 @@ func Run(c *Config) error {
 		Debug:      c.FilterDebug,
 		Interface:  c.Interface,
 		RingSizeMB: c.RingSizeMB,
+		Kernel: &KernelFilter{
+			Port:        c.Port,
+			QType:       c.FilterQtype,
+			Rcode:       c.FilterRcode,
+			QnameSuffix: c.FilterQname,
+		},
 	}
 	if err := bpfFilter.Setup(); err != nil {
 		return fmt.Errorf("unable to setup BPF filter: %w", err)
@@ -115,6 +128,7 @@ func Run(c *Config) error {
 		Fields: fields,
 	}
 	consumer.Setup()
+	bpfProbe.AggCh = consumer.probeAggQueue
 
 	// if ANY goroutine finishes wg will unblock
 	var wg sync.WaitGroup
@@ -183,11 +197,14 @@ type Consumer struct {
 	Config *Config
 	Fields []FieldID
 
-	probeQueue  chan *ProbeDTO
-	filterQueue chan *FilterDTO
+	probeQueue    chan *ProbeDTO
+	probeAggQueue chan *ProbeAggDTO
+	filterQueue   chan *FilterDTO
 
 	portToProcess map[PortNr]*ProcInfo
 	displayMap    map[UniqueDNS]*DisplayInfo
+	// kernelCalls accumulates the in-kernel sendmsg counters per process
+	kernelCalls map[int]uint64
 
 	toplikeQueue  chan *ToplikeData
 	netTopQueue   chan map[UniqueDNS]*DisplayInfo
@@ -201,9 +218,11 @@ type Consumer struct {
 func (c *Consumer) Setup() {
 	c.filterQueue = make(chan *FilterDTO, queueSize)
 	c.probeQueue = make(chan *ProbeDTO, queueSize)
+	c.probeAggQueue = make(chan *ProbeAggDTO, 1)
 
 	c.displayMap = make(map[UniqueDNS]*DisplayInfo)
 	c.portToProcess = make(map[PortNr]*ProcInfo)
+	c.kernelCalls = make(map[int]uint64)
 
 	c.toplikeQueue = make(chan *ToplikeData, 1)
 	c.netTopQueue = make(chan map[UniqueDNS]*DisplayInfo, 1)
@@ -223,6 +242,13 @@ func (c *Consumer) handleProcessData(pData *ProbeDTO) {
 	}
 }
 
+// handleProbeAggData accumulates the in-kernel per-process call counters
+func (c *Consumer) handleProbeAggData(aData *ProbeAggDTO) {
+	for _, row := range aData.Rows {
+		c.kernelCalls[int(row.Tgid)] += row.Calls
+	}
+}
+
 // handleDNSData called to match and insert into displayMap
 // (DNS query, DNS response, calling process)
 func (c *Consumer) handleDNSData(fData *FilterDTO) {
@@ -285,6 +311,8 @@ func (c *Consumer) Watch() {
 		select {
 		case pData := <-c.probeQueue:
 			c.handleProcessData(pData)
+		case aData := <-c.probeAggQueue:
+			c.handleProbeAggData(aData)
 		case fData := <-c.filterQueue:
 			c.handleDNSData(fData)
 		case <-ticker.C:
@@ -419,6 +447,18 @@ func (c *Consumer) displayMapToToplike() *ToplikeData {
 			ret.ptr++
 		}
 	}
+	// the in-kernel counters cover every probed sendmsg call, including the
+	// ones sampled out of the detailed event stream
+	for pid, calls := range c.kernelCalls {
+		if ret.Rows[pid] == nil {
+			ret.Rows[pid] = &ToplikeRow{
+				PID:  pid,
+				Comm: procCommName(uint32(pid)),
+			}
+		}
+		ret.Rows[pid].KCALLS.val = int(calls)
+		ret.kcalls += int(calls)
+	}
 	for _, v := range ret.Rows {
 		v.DNS.computePerc(ret.total)
 		v.NXDOM.computePerc(v.DNS.val)
@@ -427,10 +467,21 @@ func (c *Consumer) displayMapToToplike() *ToplikeData {
 		v.A.computePerc(v.DNS.val)
 		v.AAAA.computePerc(v.DNS.val)
 		v.PTR.computePerc(v.DNS.val)
+		v.KCALLS.computePerc(ret.kcalls)
 	}
 	return ret
 }
 
+// procCommName resolves a pid to its comm, for processes only seen through
+// the in-kernel counters
+func procCommName(pid uint32) string {
+	comm, err := getProcComm(pid)
+	if err != nil {
+		return UNK
+	}
+	return strings.TrimSpace(unix.ByteSliceToString(comm[:]))
+}
+
 // computeDataframe populates and prints the Dataframe of sql subcommand
 func (c *Consumer) computeDataframe() {
 	df := &SqllikeData{
@@ -101,3 +101,29 @@ func TestDisplayMapToToplike(t *testing.T) {
 	require.Equal(t, 5, top.total)
 	require.Equal(t, 1, len(top.Rows))
 }
+
+// TestProbeAggToToplike is used to ensure that in-kernel counter scrapes
+// accumulate per process and show up in the toplike data.
+func TestProbeAggToToplike(t *testing.T) {
+	c := Consumer{
+		Config: &Config{
+			CleanPeriod: 1 * time.Minute,
+		},
+	}
+	c.Setup()
+	c.handleProbeAggData(&ProbeAggDTO{Rows: []ProbeAggData{
+		{Tgid: 4242424, FnID: 1, Calls: 30},
+		{Tgid: 4242424, FnID: 2, Calls: 12},
+		{Tgid: 4242425, FnID: 1, Calls: 8},
+	}})
+
+	require.Equal(t, uint64(42), c.kernelCalls[4242424])
+	require.Equal(t, uint64(8), c.kernelCalls[4242425])
+
+	top := c.displayMapToToplike()
+	require.Equal(t, 50, top.kcalls)
+	require.Equal(t, 42, top.Rows[4242424].KCALLS.val)
+	require.Equal(t, 8, top.Rows[4242425].KCALLS.val)
+	// pids unseen in /proc show up as UNK
+	require.Equal(t, UNK, top.Rows[4242424].Comm)
+}
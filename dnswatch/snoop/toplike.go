@@ -27,11 +27,11 @@ import (
 const coldef = termbox.ColorDefault
 
 const doc = `dnswatch - DNS snooping
-SORTBY keys - m (PID), c (COMM), f (DNS), d (%DNSTRAFFIC), n (NXDOMAIN), o (NOERROR), s (SERVFAIL), a (A), b (AAAA), p (PTR)
+SORTBY keys - m (PID), c (COMM), f (DNS), d (%DNSTRAFFIC), n (NXDOMAIN), o (NOERROR), s (SERVFAIL), a (A), b (AAAA), p (PTR), k (KDNS)
 SORTBY keys - < (MOVE SORTING COL LEFT), > (MOVE SORTING COL RIGHT)
 TOGGLE keys - w (PID/COMM AGGREGATE), x (KEEP TERMINATED PROCESSES / DELETE OLD PROCESSES REQUEST)
 NUMBERS AGGREGATED SINCE THE START OF THE RUN
-PID | COMM(process Name) | DNS(proc traffic) | %DNS(% of DNS traffic) | %NXDOMAIN | %NOERROR | %SERVFAIL | %A | %AAAA |%PTR
+PID | COMM(process Name) | DNS(proc traffic) | %DNS(% of DNS traffic) | %NXDOMAIN | %NOERROR | %SERVFAIL | %A | %AAAA |%PTR | KDNS(in-kernel counted calls)
 `
 
 const (
@@ -45,6 +45,7 @@ const (
 	tA
 	tAAAA
 	tPTR
+	tKCALLS
 )
 
 // percentField used to store pair value, percentage
@@ -69,6 +70,9 @@ type ToplikeRow struct {
 	A     percentField
 	AAAA  percentField
 	PTR   percentField
+	// KCALLS are the sendmsg calls counted by the in-kernel aggregation
+	// map, exact even when the detailed event stream is sampled
+	KCALLS percentField
 
 	rTimestamp int64
 }
@@ -76,14 +80,15 @@ type ToplikeRow struct {
 // ToplikeData contains the entire toplike display table
 type ToplikeData struct {
 	// PID to row
-	Rows  map[int]*ToplikeRow
-	total int
-	nxdom int
-	noerr int
-	servf int
-	a     int
-	aaaa  int
-	ptr   int
+	Rows   map[int]*ToplikeRow
+	total  int
+	nxdom  int
+	noerr  int
+	servf  int
+	a      int
+	aaaa   int
+	ptr    int
+	kcalls int
 }
 
 // oldFilter keeps only the new DNS requests on screen
@@ -117,6 +122,7 @@ func (t *ToplikeData) aggregateComm() *ToplikeData {
 		aux[v.Comm].A.val += v.A.val
 		aux[v.Comm].AAAA.val += v.AAAA.val
 		aux[v.Comm].PTR.val += v.PTR.val
+		aux[v.Comm].KCALLS.val += v.KCALLS.val
 	}
 	for _, v := range aux {
 		v.DNS.computePerc(t.total)
@@ -126,6 +132,7 @@ func (t *ToplikeData) aggregateComm() *ToplikeData {
 		v.A.computePerc(v.DNS.val)
 		v.AAAA.computePerc(v.DNS.val)
 		v.PTR.computePerc(v.DNS.val)
+		v.KCALLS.computePerc(t.kcalls)
 		newRows[v.PID] = v
 	}
 	ret.Rows = newRows
@@ -153,16 +160,16 @@ func (t *ToplikeState) printDocumentation() {
 func (t *ToplikeState) printAggregated() {
 	dateFormat := "2006-01-02 15:04:05.000"
 	fmt.Printf("\nSTART TIME: %10v, LAST REFRESH: %10v\n", t.startTime.Format(dateFormat), t.lastRefresh.Format(dateFormat))
-	fmt.Printf("%-19v: %10v\n", "DNS TRAFFIC (Q-R)", t.data.total)
+	fmt.Printf("%-19v: %10v, %-19v: %10v\n", "DNS TRAFFIC (Q-R)", t.data.total, "KERNEL SENDMSG", t.data.kcalls)
 	fmt.Printf("%-19v: %10v, %-19v: %10v, %-19v: %10v\n", "A QUERIES", t.data.a, "AAAA QUERIES", t.data.aaaa, "PTR QUERIES", t.data.ptr)
 	fmt.Printf("%-19v: %10v, %-19v: %10v, %-19v: %10v\n", "NXDOMAIN RESPONSES", t.data.nxdom, "NOERROR RESPONSES", t.data.noerr, "SERVFAIL RESPONSES", t.data.servf)
 }
 
 func (t *ToplikeState) printData(maxRows int) {
-	formatHeader := "%-10v  %-15v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v\n"
-	formatRow := "%-10v  %-15.14v  %-9v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9.4v\n"
+	formatHeader := "%-10v  %-15v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v  %-9v\n"
+	formatRow := "%-10v  %-15.14v  %-9v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9.4v  %-9v\n"
 	fmt.Printf("%-10v  %-15v  %-20v  %-31v  %-31v\n", "", "", "<----TOTAL---->", "<------------RCODE------------>", "<----------QNAME--------->")
-	fmt.Printf(formatHeader, "PID", "COMM", "DNS", "%DNS", " %NXDOMAIN", "%NOERROR", " %SERVFAIL", "%A", " %AAAA", "  %PTR")
+	fmt.Printf(formatHeader, "PID", "COMM", "DNS", "%DNS", " %NXDOMAIN", "%NOERROR", " %SERVFAIL", "%A", " %AAAA", "  %PTR", "KDNS")
 	var topMap *ToplikeData
 	topMap = t.data
 	if !t.oldShow {
@@ -199,6 +206,8 @@ func (t *ToplikeState) printData(maxRows int) {
 				return vals[i].AAAA.per > vals[j].AAAA.per
 			case tPTR:
 				return vals[i].PTR.per > vals[j].PTR.per
+			case tKCALLS:
+				return vals[i].KCALLS.val > vals[j].KCALLS.val
 			default:
 				return vals[i].Comm > vals[j].Comm
 			}
@@ -210,7 +219,7 @@ func (t *ToplikeState) printData(maxRows int) {
 			if v.PID <= 0 || !t.pidShow {
 				pid = ""
 			}
-			fmt.Printf(formatRow, pid, v.Comm, v.DNS.val, v.DNS.per, v.NXDOM.per, v.NOERR.per, v.SERVF.per, v.A.per, v.AAAA.per, v.PTR.per)
+			fmt.Printf(formatRow, pid, v.Comm, v.DNS.val, v.DNS.per, v.NXDOM.per, v.NOERR.per, v.SERVF.per, v.A.per, v.AAAA.per, v.PTR.per, v.KCALLS.val)
 		}
 	}
 }
@@ -269,11 +278,11 @@ func StartTopLike(refreshChan <-chan *ToplikeData, stopChan chan<- bool, refTime
 				case ev.Ch == '<':
 					tState.sortBy--
 					if tState.sortBy < tPID {
-						tState.sortBy = tPTR
+						tState.sortBy = tKCALLS
 					}
 				case ev.Ch == '>':
 					tState.sortBy++
-					tState.sortBy = tState.sortBy % (tPTR + 1)
+					tState.sortBy = tState.sortBy % (tKCALLS + 1)
 				case ev.Ch == 'm':
 					tState.sortBy = tPID
 				case ev.Ch == 'c':
@@ -294,6 +303,8 @@ func StartTopLike(refreshChan <-chan *ToplikeData, stopChan chan<- bool, refTime
 					tState.sortBy = tAAAA
 				case ev.Ch == 'p':
 					tState.sortBy = tPTR
+				case ev.Ch == 'k':
+					tState.sortBy = tKCALLS
 				case ev.Ch == 'w':
 					tState.pidShow = !tState.pidShow
 				case ev.Ch == 'x':
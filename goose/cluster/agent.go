@@ -0,0 +1,215 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Package cluster implements the coordinated load mode of goose: one
+// controller pushes a test spec to many agents, starts them on a
+// synchronized clock, streams back their intermediate metrics and merges
+// everything into a single report.
+package cluster
+
+import (
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"sync"
+	"time"
+
+	"github.com/facebook/dns/goose/query"
+	"github.com/facebook/dns/goose/stats"
+
+	"github.com/miekg/dns"
+	log "github.com/sirupsen/logrus"
+	"go.uber.org/ratelimit"
+)
+
+// Phase is one step of the rate schedule: a query budget sent at a rate cap
+type Phase struct {
+	// MaxQPS caps the rate of the phase across all workers, 0 is unlimited
+	MaxQPS int
+	// Queries is the query budget of the phase
+	Queries int
+}
+
+// TestSpec describes one coordinated load test, pushed by the controller to
+// every agent
+type TestSpec struct {
+	// Host is the IP address of the DNS server to test.
+	Host string
+	// DPort is the destination port on the target host.
+	DPort int
+	// Net is the transport to use, "udp" or "tcp".
+	Net string
+	// Timeout is the per query timeout.
+	Timeout time.Duration
+	// RandomiseQueries adds a unique prefix to every qname to bypass caching.
+	RandomiseQueries bool
+	// Domains and QTypes describe the query mix, indexed together. QTypes
+	// are the textual forms ("A", "AAAA", ...) so the spec stays readable.
+	Domains []string
+	// QTypes holds the query type for the domain at the same index.
+	QTypes []string
+	// Workers is the number of concurrent connections per agent.
+	Workers int
+	// Phases is the rate schedule, run back to back on every agent.
+	Phases []Phase
+	// StartAt is the synchronized start time, set by the controller.
+	StartAt time.Time
+}
+
+// engines builds one query engine per phase of the schedule
+func (s *TestSpec) engines() ([]*query.Engine, error) {
+	if len(s.Domains) == 0 || len(s.Domains) != len(s.QTypes) {
+		return nil, fmt.Errorf("spec needs as many qtypes as domains, got %d and %d", len(s.QTypes), len(s.Domains))
+	}
+	if len(s.Phases) == 0 {
+		return nil, fmt.Errorf("spec has no phases")
+	}
+	qtypes := make([]dns.Type, 0, len(s.QTypes))
+	for _, qTypeStr := range s.QTypes {
+		qtype, err := query.QTypeStrToDNSQtype(qTypeStr)
+		if err != nil {
+			return nil, err
+		}
+		qtypes = append(qtypes, qtype)
+	}
+	engines := make([]*query.Engine, 0, len(s.Phases))
+	for _, phase := range s.Phases {
+		limiter := ratelimit.NewUnlimited()
+		if phase.MaxQPS > 0 {
+			limiter = ratelimit.New(phase.MaxQPS)
+		}
+		engines = append(engines, &query.Engine{
+			DPort:            s.DPort,
+			Host:             s.Host,
+			Net:              s.Net,
+			Timeout:          s.Timeout,
+			RandomiseQueries: s.RandomiseQueries,
+			Domains:          s.Domains,
+			QTypes:           qtypes,
+			Workers:          s.Workers,
+			TotalQueries:     phase.Queries,
+			Limiter:          limiter,
+			NowFunc:          time.Now,
+		})
+	}
+	return engines, nil
+}
+
+// ResultsResponse is the reply of the agent's /results endpoint
+type ResultsResponse struct {
+	// Running reports whether the agent is still sending queries
+	Running bool
+	// Metrics are the merged metrics of all phases so far
+	Metrics *stats.ExportedMetrics
+}
+
+// Agent runs on every load-generating host and executes test specs pushed
+// by a controller
+type Agent struct {
+	// Addr is the address the agent control endpoint listens on
+	Addr string
+
+	mu      sync.Mutex
+	engines []*query.Engine
+	running bool
+}
+
+// Handler returns the agent control endpoints
+func (a *Agent) Handler() http.Handler {
+	mux := http.NewServeMux()
+	mux.HandleFunc("/start", a.handleStart)
+	mux.HandleFunc("/metrics", a.handleMetrics)
+	mux.HandleFunc("/results", a.handleResults)
+	return mux
+}
+
+// Run serves the agent control endpoints until the process is stopped
+func (a *Agent) Run() error {
+	log.Infof("goose agent listening on %s", a.Addr)
+	return http.ListenAndServe(a.Addr, a.Handler())
+}
+
+func (a *Agent) handleStart(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		http.Error(w, "POST required", http.StatusMethodNotAllowed)
+		return
+	}
+	var spec TestSpec
+	if err := json.NewDecoder(r.Body).Decode(&spec); err != nil {
+		http.Error(w, err.Error(), http.StatusBadRequest)
+		return
+	}
+	engines, err := spec.engines()
+	if err != nil {
+		http.Error(w, err.Error(), http.StatusBadRequest)
+		return
+	}
+	a.mu.Lock()
+	if a.running {
+		a.mu.Unlock()
+		http.Error(w, "a test is already running", http.StatusConflict)
+		return
+	}
+	a.running = true
+	a.engines = engines
+	a.mu.Unlock()
+	go a.runSpec(&spec, engines)
+}
+
+// runSpec waits for the synchronized start and runs the phases back to back
+func (a *Agent) runSpec(spec *TestSpec, engines []*query.Engine) {
+	if wait := time.Until(spec.StartAt); wait > 0 {
+		log.Infof("waiting %v for the synchronized start", wait)
+		time.Sleep(wait)
+	}
+	sigpause := make(chan struct{}, 1)
+	for i, engine := range engines {
+		log.Infof("running phase %d of %d", i+1, len(engines))
+		if err := engine.Run(sigpause); err != nil {
+			log.Errorf("phase %d failed: %v", i+1, err)
+		}
+	}
+	a.mu.Lock()
+	a.running = false
+	a.mu.Unlock()
+}
+
+// snapshot returns the engines of the current test and whether it still runs
+func (a *Agent) snapshot() ([]*query.Engine, bool) {
+	a.mu.Lock()
+	defer a.mu.Unlock()
+	return a.engines, a.running
+}
+
+func (a *Agent) handleMetrics(w http.ResponseWriter, _ *http.Request) {
+	engines, _ := a.snapshot()
+	metrics := make([]*stats.ExportedMetrics, 0, len(engines))
+	for _, engine := range engines {
+		metrics = append(metrics, engine.ExportIntermediateResults())
+	}
+	if err := json.NewEncoder(w).Encode(stats.MergeMetrics(metrics)); err != nil {
+		log.Errorf("failed to encode metrics: %v", err)
+	}
+}
+
+func (a *Agent) handleResults(w http.ResponseWriter, _ *http.Request) {
+	engines, running := a.snapshot()
+	metrics := make([]*stats.ExportedMetrics, 0, len(engines))
+	for _, engine := range engines {
+		metrics = append(metrics, engine.ExportResults())
+	}
+	resp := ResultsResponse{Running: running, Metrics: stats.MergeMetrics(metrics)}
+	if err := json.NewEncoder(w).Encode(resp); err != nil {
+		log.Errorf("failed to encode results: %v", err)
+	}
+}
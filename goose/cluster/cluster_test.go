@@ -0,0 +1,118 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package cluster
+
+import (
+	"net"
+	"net/http/httptest"
+	"strconv"
+	"testing"
+	"time"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+)
+
+// runLocalDNSServer starts a UDP DNS server answering every query with one
+// A record, as CheckResponse expects exactly one answer
+func runLocalDNSServer(t *testing.T) (host string, port int, stop func()) {
+	pc, err := net.ListenPacket("udp", "127.0.0.1:0")
+	require.NoError(t, err)
+	server := &dns.Server{PacketConn: pc, Handler: dns.HandlerFunc(func(w dns.ResponseWriter, r *dns.Msg) {
+		m := new(dns.Msg)
+		m.SetReply(r)
+		m.Answer = append(m.Answer, &dns.A{
+			Hdr: dns.RR_Header{Name: r.Question[0].Name, Rrtype: dns.TypeA, Class: dns.ClassINET, Ttl: 60},
+			A:   net.IPv4(127, 0, 0, 1),
+		})
+		_ = w.WriteMsg(m)
+	})}
+	go func() {
+		_ = server.ActivateAndServe()
+	}()
+	host, portStr, err := net.SplitHostPort(pc.LocalAddr().String())
+	require.NoError(t, err)
+	port, err = strconv.Atoi(portStr)
+	require.NoError(t, err)
+	return host, port, func() { _ = server.Shutdown() }
+}
+
+func Test_ControllerRunsCoordinatedTest(t *testing.T) {
+	host, port, stop := runLocalDNSServer(t)
+	defer stop()
+
+	agent := &Agent{}
+	agentServer := httptest.NewServer(agent.Handler())
+	defer agentServer.Close()
+
+	controller := &Controller{Agents: []string{agentServer.Listener.Addr().String()}}
+	spec := TestSpec{
+		Host:    host,
+		DPort:   port,
+		Net:     "udp",
+		Timeout: 2 * time.Second,
+		Domains: []string{"example.com"},
+		QTypes:  []string{"A"},
+		Workers: 2,
+		Phases:  []Phase{{Queries: 4}, {Queries: 2}},
+	}
+	merged, err := controller.Run(spec, 10*time.Millisecond, 0, nil)
+	require.NoError(t, err)
+	require.Equal(t, 6, merged.Processed)
+	require.Equal(t, 0, merged.Errors)
+	require.Equal(t, uint64(6), merged.Latencies.Count())
+}
+
+func Test_AgentRejectsConcurrentStart(t *testing.T) {
+	agent := &Agent{}
+	agentServer := httptest.NewServer(agent.Handler())
+	defer agentServer.Close()
+
+	controller := &Controller{Agents: []string{agentServer.Listener.Addr().String()}}
+	spec := TestSpec{
+		Host:    "127.0.0.1",
+		DPort:   1,
+		Net:     "udp",
+		Timeout: time.Millisecond,
+		Domains: []string{"example.com"},
+		QTypes:  []string{"A"},
+		Workers: 1,
+		Phases:  []Phase{{Queries: 1}},
+	}
+	// hold the agent busy with a start far in the future
+	require.NoError(t, controller.Start(spec, time.Minute))
+	err := controller.Start(spec, time.Minute)
+	require.Error(t, err)
+	require.Contains(t, err.Error(), "refused to start")
+}
+
+func Test_SpecValidation(t *testing.T) {
+	spec := &TestSpec{Domains: []string{"example.com"}, QTypes: []string{"A"}}
+	_, err := spec.engines()
+	require.Error(t, err, "a spec without phases is rejected")
+
+	spec.Phases = []Phase{{Queries: 1}}
+	spec.QTypes = []string{"DERP"}
+	_, err = spec.engines()
+	require.Error(t, err, "an unknown qtype is rejected")
+
+	spec.QTypes = []string{"A", "AAAA"}
+	_, err = spec.engines()
+	require.Error(t, err, "qtypes must match domains one to one")
+
+	spec.QTypes = []string{"A"}
+	engines, err := spec.engines()
+	require.NoError(t, err)
+	require.Len(t, engines, 1)
+}
@@ -0,0 +1,160 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package cluster
+
+import (
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"strings"
+	"time"
+
+	"github.com/facebook/dns/goose/stats"
+
+	log "github.com/sirupsen/logrus"
+)
+
+// resultsPollInterval is how often the controller checks whether all agents
+// have finished
+const resultsPollInterval = time.Second
+
+// Controller coordinates a load test across many goose agents
+type Controller struct {
+	// Agents lists the control addresses (host:port) of the agents
+	Agents []string
+	// HTTPClient reaches the agents, http.DefaultClient when nil
+	HTTPClient *http.Client
+}
+
+func (c *Controller) client() *http.Client {
+	if c.HTTPClient != nil {
+		return c.HTTPClient
+	}
+	return http.DefaultClient
+}
+
+func agentURL(agent, path string) string {
+	if !strings.HasPrefix(agent, "http://") && !strings.HasPrefix(agent, "https://") {
+		agent = "http://" + agent
+	}
+	return agent + path
+}
+
+func (c *Controller) get(agent, path string, out interface{}) error {
+	resp, err := c.client().Get(agentURL(agent, path))
+	if err != nil {
+		return fmt.Errorf("querying agent %s: %w", agent, err)
+	}
+	defer resp.Body.Close()
+	if resp.StatusCode != http.StatusOK {
+		return fmt.Errorf("agent %s returned %s for %s", agent, resp.Status, path)
+	}
+	return json.NewDecoder(resp.Body).Decode(out)
+}
+
+// Start pushes spec to every agent with a start time startDelay from now,
+// so all agents begin sending on a synchronized clock. The delay must cover
+// the slowest agent round trip.
+func (c *Controller) Start(spec TestSpec, startDelay time.Duration) error {
+	spec.StartAt = time.Now().Add(startDelay)
+	body, err := json.Marshal(spec)
+	if err != nil {
+		return err
+	}
+	for _, agent := range c.Agents {
+		resp, postErr := c.client().Post(agentURL(agent, "/start"), "application/json", bytes.NewReader(body))
+		if postErr != nil {
+			return fmt.Errorf("starting agent %s: %w", agent, postErr)
+		}
+		resp.Body.Close()
+		if resp.StatusCode != http.StatusOK {
+			return fmt.Errorf("agent %s refused to start: %s", agent, resp.Status)
+		}
+		log.Infof("agent %s starts at %v", agent, spec.StartAt)
+	}
+	return nil
+}
+
+// PollIntermediate fetches and merges the metrics every agent collected
+// since it was last polled
+func (c *Controller) PollIntermediate() (*stats.ExportedMetrics, error) {
+	metrics := make([]*stats.ExportedMetrics, 0, len(c.Agents))
+	for _, agent := range c.Agents {
+		m := &stats.ExportedMetrics{}
+		if err := c.get(agent, "/metrics", m); err != nil {
+			return nil, err
+		}
+		metrics = append(metrics, m)
+	}
+	return stats.MergeMetrics(metrics), nil
+}
+
+// WaitResults blocks until every agent has finished its schedule and
+// returns the merged final results
+func (c *Controller) WaitResults() (*stats.ExportedMetrics, error) {
+	for {
+		metrics := make([]*stats.ExportedMetrics, 0, len(c.Agents))
+		running := false
+		for _, agent := range c.Agents {
+			var resp ResultsResponse
+			if err := c.get(agent, "/results", &resp); err != nil {
+				return nil, err
+			}
+			if resp.Running {
+				running = true
+				break
+			}
+			metrics = append(metrics, resp.Metrics)
+		}
+		if !running {
+			return stats.MergeMetrics(metrics), nil
+		}
+		time.Sleep(resultsPollInterval)
+	}
+}
+
+// Run drives a full coordinated test: it starts all agents, reports merged
+// intermediate metrics every samplingInterval while the test runs, and
+// returns the merged final results.
+func (c *Controller) Run(spec TestSpec, startDelay, samplingInterval time.Duration, reporter stats.Reporter) (*stats.ExportedMetrics, error) {
+	if err := c.Start(spec, startDelay); err != nil {
+		return nil, err
+	}
+	stopSampling := make(chan struct{})
+	if samplingInterval > 0 && reporter != nil {
+		samplingTicker := time.NewTicker(samplingInterval)
+		go func() {
+			defer samplingTicker.Stop()
+			for {
+				select {
+				case <-samplingTicker.C:
+					sampledMetrics, err := c.PollIntermediate()
+					if err != nil {
+						log.Errorf("Failed to poll agents %v", err)
+						continue
+					}
+					if repErr := reporter.ReportMetrics(sampledMetrics); repErr != nil {
+						log.Errorf("Failed to report metrics %v", repErr)
+					}
+				case <-stopSampling:
+					return
+				}
+			}
+		}()
+	}
+	merged, err := c.WaitResults()
+	close(stopSampling)
+	return merged, err
+}
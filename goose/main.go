@@ -19,12 +19,13 @@ import (
 	"net/http"
 	"os"
 	"os/signal"
-	"sync"
+	"strings"
 	"syscall"
 	"time"
 
 	_ "net/http/pprof"
 
+	"github.com/facebook/dns/goose/cluster"
 	"github.com/facebook/dns/goose/query"
 	"github.com/facebook/dns/goose/report"
 	"github.com/facebook/dns/goose/stats"
@@ -55,6 +56,11 @@ var (
 	monitorPort         int
 	monitorHost         string
 	parallelConnections int
+	proto               string
+	agentMode           bool
+	agentAddr           string
+	agents              string
+	startDelay          time.Duration
 	reportJSON          bool
 	inputFile           string
 	exporterAddr        string
@@ -81,6 +87,11 @@ func main() {
 	flag.BoolVar(&debugger, "pprof", false, "Enable pprof")
 	flag.IntVar(&maxqps, "max-qps", 0, "max number of QPS")
 	flag.IntVar(&parallelConnections, "parallel-connections", 1, "max number of parallel connections")
+	flag.StringVar(&proto, "proto", "udp", "Protocol to use for queries: udp or tcp")
+	flag.BoolVar(&agentMode, "agent", false, "Run as a load-generating agent waiting for a goose controller")
+	flag.StringVar(&agentAddr, "agent-addr", ":6868", "Agent control endpoint bind address")
+	flag.StringVar(&agents, "agents", "", "Comma separated agent host:port list; runs as the controller of a coordinated test")
+	flag.DurationVar(&startDelay, "start-delay", 2*time.Second, "Delay before the synchronized start of a coordinated test")
 	flag.BoolVar(&reportJSON, "report-json", false, "Report run results to stdout in json format")
 	flag.Parse()
 
@@ -97,6 +108,15 @@ func main() {
 		log.Fatalf("Unrecognized log level: %v", logLevel)
 	}
 
+	if proto != "udp" && proto != "tcp" {
+		log.Fatalf("Unrecognized protocol: %v", proto)
+	}
+
+	if agentMode {
+		agent := &cluster.Agent{Addr: agentAddr}
+		log.Fatalf("Agent stopped: %v", agent.Run())
+	}
+
 	if domain == "" && inputFile == "" {
 		log.Fatal("Need to specify either domain or input file, neither is specified")
 
@@ -191,6 +211,35 @@ func main() {
 			log.Errorf("Failed to initialize stats reporter %v", reporterInitError)
 		}
 	}()
+	if agents != "" {
+		qTypeStrs := make([]string, 0, len(qtypes))
+		for _, qtype := range qtypes {
+			qTypeStrs = append(qTypeStrs, qtype.String())
+		}
+		controller := &cluster.Controller{Agents: strings.Split(agents, ",")}
+		spec := cluster.TestSpec{
+			Host:             host,
+			DPort:            dport,
+			Net:              proto,
+			Timeout:          timeout,
+			RandomiseQueries: randomiseQueries,
+			Domains:          qnames,
+			QTypes:           qTypeStrs,
+			Workers:          parallelConnections,
+			Phases:           []cluster.Phase{{MaxQPS: maxqps, Queries: totalQueries}},
+		}
+		log.Infof("Coordinating %d agents against %s:%d", len(controller.Agents), host, dport)
+		mergedMetrics, runErr := controller.Run(spec, startDelay, samplingInterval, reporter)
+		if runErr != nil {
+			log.Fatalf("Coordinated test failed: %v", runErr)
+		}
+		log.Info("The merged test results are:")
+		if repErr := reporter.ReportMetrics(mergedMetrics); repErr != nil {
+			log.Errorf("Failed to report metrics %v", repErr)
+		}
+		return
+	}
+
 	var rate ratelimit.Limiter
 	qpsStr := "Unlimited"
 	if maxqps > 0 {
@@ -201,7 +250,20 @@ func main() {
 		rate = ratelimit.NewUnlimited()
 	}
 	log.Infof(goosestr, host, dport, qpsStr)
-	runState := query.NewRunState(totalQueries, rate, daemon, time.Now)
+	engine := &query.Engine{
+		DPort:            dport,
+		Host:             host,
+		Net:              proto,
+		Timeout:          timeout,
+		RandomiseQueries: randomiseQueries,
+		Domains:          qnames,
+		QTypes:           qtypes,
+		Workers:          parallelConnections,
+		TotalQueries:     totalQueries,
+		Limiter:          rate,
+		Daemon:           daemon,
+		NowFunc:          time.Now,
+	}
 	if duration != 0 && !daemon {
 		timer := time.NewTimer(duration)
 		go func() {
@@ -218,7 +280,7 @@ func main() {
 			for {
 				select {
 				case <-samplingTicker.C:
-					sampledMetrics := runState.ExportIntermediateResults()
+					sampledMetrics := engine.ExportIntermediateResults()
 					repErr := reporter.ReportMetrics(sampledMetrics)
 					if err != nil {
 						log.Errorf("Failed to report metrics %v", repErr)
@@ -231,24 +293,13 @@ func main() {
 	}
 
 	go func() {
-
 		log.Infof(
 			"Starting the test and running %d connections in parallel",
 			parallelConnections,
 		)
-		var wg sync.WaitGroup
-		for i := 0; i < parallelConnections; i++ {
-			wg.Add(1)
-			go func() {
-				qErr := query.RunQueries(dport, host, qnames, timeout, randomiseQueries, qtypes, time.Now, runState, sigPause)
-				if err != nil {
-					log.Errorf("Failed to run queries %v", qErr)
-				}
-				wg.Done()
-			}()
+		if runErr := engine.Run(sigPause); runErr != nil {
+			log.Errorf("Failed to run queries %v", runErr)
 		}
-		wg.Wait()
-
 		log.Info("Finished running all connections")
 		close(sigStop)
 	}()
@@ -260,7 +311,7 @@ func main() {
 	if !daemon {
 		log.Info("The test results are:")
 
-		finishedMetrics := runState.ExportResults()
+		finishedMetrics := engine.ExportResults()
 		err = reporter.ReportMetrics(finishedMetrics)
 		if err != nil {
 			log.Errorf("Failed to report metrics %v", err)
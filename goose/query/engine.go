@@ -0,0 +1,127 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package query
+
+import (
+	"sync"
+	"time"
+
+	"github.com/facebook/dns/goose/stats"
+
+	"github.com/miekg/dns"
+	"go.uber.org/ratelimit"
+)
+
+// Engine drives a pool of workers, each with its own persistent connection
+// and its own RunState, so the load a single goose instance can generate is
+// not serialized on one socket or one state mutex. All workers share the
+// rate limiter, which caps the aggregate QPS; the per-worker states are
+// merged whenever results are exported.
+type Engine struct {
+	// DPort is the destination port on the target host.
+	DPort int
+	// Host is the IP address of the DNS server to test.
+	Host string
+	// Net is the transport to use for the connections, "udp" or "tcp".
+	Net string
+	// Timeout is the per query timeout.
+	Timeout time.Duration
+	// RandomiseQueries adds a unique prefix to every qname to bypass caching.
+	RandomiseQueries bool
+	// Domains and QTypes describe the query mix, indexed together.
+	Domains []string
+	// QTypes holds the query type for the domain at the same index.
+	QTypes []dns.Type
+	// Workers is the number of concurrent connections.
+	Workers int
+	// TotalQueries is the query budget, spread over the workers.
+	TotalQueries int
+	// Limiter caps the aggregate rate across all workers.
+	Limiter ratelimit.Limiter
+	// Daemon keeps the workers sending until the process is stopped.
+	Daemon bool
+	// NowFunc is used by unittests to manipulate Now(). normally it's time.Now
+	NowFunc func() time.Time
+
+	initOnce sync.Once
+	states   []*RunState
+}
+
+// splitQueries spreads total queries over workers as evenly as possible.
+func splitQueries(total, workers int) []int {
+	if workers < 1 {
+		workers = 1
+	}
+	split := make([]int, workers)
+	for i := range split {
+		split[i] = total / workers
+		if i < total%workers {
+			split[i]++
+		}
+	}
+	return split
+}
+
+// initStates lazily creates the per-worker run states. Both Run and the
+// export methods call it, so a reporting ticker can start before the test.
+func (e *Engine) initStates() {
+	e.initOnce.Do(func() {
+		for _, n := range splitQueries(e.TotalQueries, e.Workers) {
+			e.states = append(e.states, NewRunState(n, e.Limiter, e.Daemon, e.NowFunc))
+		}
+	})
+}
+
+// ExportIntermediateResults merges the intermediate results of all workers
+func (e *Engine) ExportIntermediateResults() *stats.ExportedMetrics {
+	e.initStates()
+	metrics := make([]*stats.ExportedMetrics, 0, len(e.states))
+	for _, state := range e.states {
+		metrics = append(metrics, state.ExportIntermediateResults())
+	}
+	return stats.MergeMetrics(metrics)
+}
+
+// ExportResults merges the final results of all workers
+func (e *Engine) ExportResults() *stats.ExportedMetrics {
+	e.initStates()
+	metrics := make([]*stats.ExportedMetrics, 0, len(e.states))
+	for _, state := range e.states {
+		metrics = append(metrics, state.ExportResults())
+	}
+	return stats.MergeMetrics(metrics)
+}
+
+// Run starts all workers and blocks until they have drained their query
+// budgets. Each worker dials its own connection, so a failure on one does
+// not stop the others; the first worker error is returned.
+func (e *Engine) Run(sigpause chan struct{}) error {
+	e.initStates()
+	var wg sync.WaitGroup
+	errs := make(chan error, len(e.states))
+	for _, state := range e.states {
+		wg.Add(1)
+		go func(state *RunState) {
+			defer wg.Done()
+			client := DNSClient(e.Timeout)
+			client.Net = e.Net
+			if err := runWorker(client, e.DPort, e.Host, e.Domains, e.Timeout, e.RandomiseQueries, e.QTypes, e.NowFunc, state, sigpause); err != nil {
+				errs <- err
+			}
+		}(state)
+	}
+	wg.Wait()
+	close(errs)
+	return <-errs
+}
@@ -0,0 +1,84 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package query
+
+import (
+	"testing"
+
+	"github.com/miekg/dns"
+	"github.com/stretchr/testify/require"
+	"go.uber.org/ratelimit"
+)
+
+func Test_splitQueries(t *testing.T) {
+	require.Equal(t, []int{5}, splitQueries(5, 1))
+	require.Equal(t, []int{2, 2, 1}, splitQueries(5, 3))
+	require.Equal(t, []int{1, 1, 0}, splitQueries(2, 3))
+	// a bogus worker count still gets the full budget
+	require.Equal(t, []int{7}, splitQueries(7, 0))
+}
+
+func Test_EngineMergesWorkerStates(t *testing.T) {
+	tf := timefunc()
+	engine := &Engine{
+		Workers:      2,
+		TotalQueries: 4,
+		Limiter:      ratelimit.NewUnlimited(),
+		NowFunc:      tf,
+	}
+	engine.initStates()
+	require.Len(t, engine.states, 2)
+
+	reqMsg := new(dns.Msg)
+	reqMsg.SetQuestion(dns.Fqdn("goose.1234567.somedomain.com."), dns.TypeANY)
+	RunQuery(reqMsg, doSendMsgSuccess, tf, engine.states[0])
+	RunQuery(reqMsg, doSendMsgSuccess, tf, engine.states[1])
+	RunQuery(reqMsg, doSendMsgFailure, tf, engine.states[1])
+
+	merged := engine.ExportResults()
+	require.Equal(t, 2, merged.Processed)
+	require.Equal(t, 1, merged.Errors)
+	require.Equal(t, uint64(3), merged.Latencies.Count())
+}
+
+func Test_EngineMergesIntermediateResults(t *testing.T) {
+	tf := timefunc()
+	engine := &Engine{
+		Workers:      2,
+		TotalQueries: 2,
+		Limiter:      ratelimit.NewUnlimited(),
+		NowFunc:      tf,
+	}
+
+	reqMsg := new(dns.Msg)
+	reqMsg.SetQuestion(dns.Fqdn("goose.1234567.somedomain.com."), dns.TypeANY)
+	// the export methods initialize the states, as the reporting ticker may
+	// run before the workers are started
+	merged := engine.ExportIntermediateResults()
+	require.Equal(t, 0, merged.Processed)
+
+	RunQuery(reqMsg, doSendMsgSuccess, tf, engine.states[0])
+	RunQuery(reqMsg, doSendMsgFailure, tf, engine.states[1])
+
+	merged = engine.ExportIntermediateResults()
+	require.Equal(t, 1, merged.Processed)
+	require.Equal(t, 1, merged.Errors)
+	require.Equal(t, uint64(2), merged.Latencies.Count())
+
+	// already exported samples are not reported twice
+	merged = engine.ExportIntermediateResults()
+	require.Equal(t, 0, merged.Processed)
+	require.Equal(t, 0, merged.Errors)
+	require.Zero(t, merged.Latencies.Count())
+}
@@ -190,13 +190,13 @@ type RunState struct {
 	// errors is the number of queries that failed.
 	errors int
 	// unexportedLatencies contain per query latency which havent been exported yet.
-	unexportedLatencies []float64
+	unexportedLatencies *stats.LatencyHistogram
 	// lastExportedAt is the last time we printed the intermediate state.
 	lastExportedAt        time.Time
 	lastExportedProcessed int
 	lastExportedErrors    int
 	// alreadyExportedLatencies contain per query latency which have already been exported by `ExportIntermediateResults`, these still need to be accounted at the final export
-	alreadyExportedLatencies []float64
+	alreadyExportedLatencies *stats.LatencyHistogram
 
 	// are we running in daemon mode
 	daemon bool
@@ -215,11 +215,11 @@ func NewRunState(queriesToSend int, limiter ratelimit.Limiter, daemon bool, nowf
 		startTime:                nowfunc(),
 		processed:                0,
 		errors:                   0,
-		unexportedLatencies:      make([]float64, 0),
+		unexportedLatencies:      stats.NewLatencyHistogram(),
 		lastExportedAt:           time.Time{},
 		lastExportedProcessed:    0,
 		lastExportedErrors:       0,
-		alreadyExportedLatencies: make([]float64, 0),
+		alreadyExportedLatencies: stats.NewLatencyHistogram(),
 		daemon:                   daemon,
 		m:                        sync.Mutex{},
 		nowfunc:                  nowfunc,
@@ -240,10 +240,15 @@ func (r *RunState) ExportIntermediateResults() *stats.ExportedMetrics {
 
 	elapsed := r.nowfunc().Sub(startTime)
 	latencies := r.unexportedLatencies
-	if !r.daemon { // in daemon mode we don't care about the final export's correctness, but this slice would grow indefinitely, so let's not save already exported latencies
-		r.alreadyExportedLatencies = append(r.alreadyExportedLatencies, r.unexportedLatencies...)
+	if !r.daemon {
+		// the histogram hands constant memory for daemon mode for free, but
+		// the already exported samples still only matter for the final export
+		if r.alreadyExportedLatencies == nil {
+			r.alreadyExportedLatencies = stats.NewLatencyHistogram()
+		}
+		r.alreadyExportedLatencies.Merge(r.unexportedLatencies)
 	}
-	r.unexportedLatencies = make([]float64, 0)
+	r.unexportedLatencies = stats.NewLatencyHistogram()
 
 	r.lastExportedAt = r.nowfunc()
 	r.lastExportedProcessed = r.processed
@@ -260,11 +265,14 @@ func (r *RunState) ExportIntermediateResults() *stats.ExportedMetrics {
 func (r *RunState) ExportResults() *stats.ExportedMetrics {
 	r.m.Lock()
 	defer r.m.Unlock()
+	latencies := stats.NewLatencyHistogram()
+	latencies.Merge(r.alreadyExportedLatencies)
+	latencies.Merge(r.unexportedLatencies)
 	return &stats.ExportedMetrics{
 		Elapsed:   r.nowfunc().Sub(r.startTime),
 		Processed: r.processed,
 		Errors:    r.errors,
-		Latencies: append(r.alreadyExportedLatencies, r.unexportedLatencies...),
+		Latencies: latencies,
 	}
 }
 
@@ -290,11 +298,16 @@ func (r *RunState) incErrors() {
 	r.errors++
 }
 
-// addLatency records a query execution time
+// addLatency records a query execution time. The histogram buckets are
+// atomic, the lock only protects the histogram pointer against a concurrent
+// intermediate export swapping it out.
 func (r *RunState) addLatency(latency float64) {
 	r.m.Lock()
 	defer r.m.Unlock()
-	r.unexportedLatencies = append(r.unexportedLatencies, latency)
+	if r.unexportedLatencies == nil {
+		r.unexportedLatencies = stats.NewLatencyHistogram()
+	}
+	r.unexportedLatencies.Add(latency)
 }
 
 func (r *RunState) getProcessedQueries() int {
@@ -303,9 +316,15 @@ func (r *RunState) getProcessedQueries() int {
 	return r.processed + r.errors
 }
 
-// RunQueries starts loading the target host with DNS queries
+// RunQueries starts loading the target host with DNS queries over a single
+// UDP connection. Engine runs one of these loops per worker connection.
 func RunQueries(dport int, host string, domains []string, timeout time.Duration, randomiseQueries bool, qTypes []dns.Type, now func() time.Time, runState *RunState, sigpause chan struct{}) error {
-	client := DNSClient(timeout)
+	return runWorker(DNSClient(timeout), dport, host, domains, timeout, randomiseQueries, qTypes, now, runState, sigpause)
+}
+
+// runWorker drives one persistent connection, sending queries until the run
+// state's budget is drained.
+func runWorker(client *dns.Client, dport int, host string, domains []string, timeout time.Duration, randomiseQueries bool, qTypes []dns.Type, now func() time.Time, runState *RunState, sigpause chan struct{}) error {
 	conn, err := ClientConnection(client, dport, host)
 	if err != nil {
 		return err
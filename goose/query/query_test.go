@@ -102,6 +102,14 @@ func Test_MakeReq(t *testing.T) {
 	)
 }
 
+func latencyHist(samples ...float64) *stats.LatencyHistogram {
+	h := stats.NewLatencyHistogram()
+	for _, s := range samples {
+		h.Add(s)
+	}
+	return h
+}
+
 func timefunc() func() time.Time {
 	i := 0
 	return func() time.Time {
@@ -131,14 +139,14 @@ func Test_RunQuery(t *testing.T) {
 
 	RunQuery(reqMsg, doSendMsgSuccess, tf, runState)
 
-	expected := &stats.ExportedMetrics{Elapsed: 30000000, Processed: 1, Errors: 0, Latencies: []float64{10000000}}
+	expected := &stats.ExportedMetrics{Elapsed: 30000000, Processed: 1, Errors: 0, Latencies: latencyHist(10000000)}
 	exportedMetrics := runState.ExportResults()
 	require.Equal(t, expected, exportedMetrics)
 
 	RunQuery(reqMsg, doSendMsgFailure, tf, runState)
 
 	expected.Errors = 1
-	expected.Latencies = append(expected.Latencies, 10000000)
+	expected.Latencies.Add(10000000)
 	expected.Elapsed = 60000000
 
 	exportedMetrics = runState.ExportResults()
@@ -147,7 +155,7 @@ func Test_RunQuery(t *testing.T) {
 	RunQuery(reqMsg, doSendMsgNil, tf, runState)
 
 	expected.Errors = 2
-	expected.Latencies = append(expected.Latencies, 10000000)
+	expected.Latencies.Add(10000000)
 	expected.Elapsed = 90000000
 	exportedMetrics = runState.ExportResults()
 	require.Equal(t, expected, exportedMetrics)
@@ -161,7 +169,7 @@ func Test_exportIntermediateMetrics(t *testing.T) {
 
 	RunQuery(reqMsg, doSendMsgSuccess, tf, runState)
 
-	expected := &stats.ExportedMetrics{Elapsed: 30000000, Processed: 1, Errors: 0, Latencies: []float64{10000000}}
+	expected := &stats.ExportedMetrics{Elapsed: 30000000, Processed: 1, Errors: 0, Latencies: latencyHist(10000000)}
 	exportedMetrics := runState.ExportIntermediateResults()
 	require.Equal(t, expected, exportedMetrics)
 
@@ -169,6 +177,7 @@ func Test_exportIntermediateMetrics(t *testing.T) {
 
 	expected.Errors = 1
 	expected.Processed = 0
+	expected.Latencies = latencyHist(10000000)
 
 	exportedMetrics = runState.ExportIntermediateResults()
 	require.Equal(t, expected, exportedMetrics)
@@ -177,7 +186,7 @@ func Test_exportIntermediateMetrics(t *testing.T) {
 
 	expected.Errors = 2
 	expected.Processed = 1
-	expected.Latencies = append(expected.Latencies, 10000000, 10000000)
+	expected.Latencies = latencyHist(10000000, 10000000, 10000000)
 	expected.Elapsed = 110000000
 	exportedMetrics = runState.ExportResults()
 	require.Equal(t, expected, exportedMetrics)
@@ -201,5 +210,5 @@ func Test_StateAddLatency(t *testing.T) {
 	runState := &RunState{nowfunc: timefunc()}
 
 	runState.addLatency(2)
-	require.Equal(t, []float64{2}, runState.ExportResults().Latencies)
+	require.Equal(t, latencyHist(2), runState.ExportResults().Latencies)
 }
@@ -26,7 +26,11 @@ import (
 )
 
 func TestReportMetrics(t *testing.T) {
-	exportedMetrics := &stats.ExportedMetrics{Elapsed: 100 * time.Second, Processed: 1, Errors: 0, Latencies: []float64{1000, 2000, 3000}}
+	latencies := stats.NewLatencyHistogram()
+	for _, sample := range []float64{1000, 2000, 3000} {
+		latencies.Add(sample)
+	}
+	exportedMetrics := &stats.ExportedMetrics{Elapsed: 100 * time.Second, Processed: 1, Errors: 0, Latencies: latencies}
 	r := &PrometheusMetricsReporter{Addr: ":0"}
 	go func() {
 		_ = r.Initialize()
@@ -0,0 +1,247 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package stats
+
+import (
+	"encoding/json"
+	"fmt"
+	"math"
+	"math/bits"
+	"sync/atomic"
+)
+
+const (
+	// histSubBits gives 2^histSubBits linear sub-buckets per power of two,
+	// which bounds the relative error of any reported quantile to
+	// 1/2^histSubBits (~3%).
+	histSubBits  = 5
+	histSubCount = 1 << histSubBits
+	// histMaxExp is the largest power of two the histogram resolves; with
+	// nanosecond samples 2^43 ns is ~2.4 hours, far beyond any query timeout.
+	// Larger samples are clamped into the last bucket.
+	histMaxExp      = 43
+	histBucketCount = (histMaxExp-histSubBits+1)*histSubCount + histSubCount
+)
+
+// LatencyHistogram is a fixed-size log-linear histogram (the HDR histogram
+// layout) of latency samples in nanoseconds. Unlike the raw sample slice it
+// replaces, its memory is constant no matter how long a soak test runs, and
+// computing a quantile walks the buckets instead of sorting every sample.
+// The buckets are individual atomic counters, so many workers can ingest
+// samples concurrently without sharing a lock.
+type LatencyHistogram struct {
+	buckets [histBucketCount]atomic.Uint64
+	count   atomic.Uint64
+	sum     atomic.Uint64
+	min     atomic.Uint64
+	max     atomic.Uint64
+}
+
+// NewLatencyHistogram returns an empty histogram
+func NewLatencyHistogram() *LatencyHistogram {
+	h := &LatencyHistogram{}
+	h.min.Store(math.MaxUint64)
+	return h
+}
+
+// histBucket maps a sample to its bucket: values below histSubCount map
+// one to one, larger values keep histSubBits significant bits below the
+// leading one.
+func histBucket(v uint64) int {
+	if v < histSubCount {
+		return int(v)
+	}
+	exp := bits.Len64(v) - 1
+	if exp > histMaxExp {
+		return histBucketCount - 1
+	}
+	sub := int((v >> (uint(exp) - histSubBits)) & (histSubCount - 1))
+	return (exp-histSubBits)*histSubCount + histSubCount + sub
+}
+
+// histBucketUpper returns the largest sample value a bucket can hold
+func histBucketUpper(idx int) float64 {
+	if idx < histSubCount {
+		return float64(idx)
+	}
+	k := uint((idx - histSubCount) / histSubCount)
+	sub := uint64((idx-histSubCount)%histSubCount) + histSubCount
+	return float64((sub+1)<<k - 1)
+}
+
+// Add records one latency sample, given in nanoseconds
+func (h *LatencyHistogram) Add(latency float64) {
+	v := uint64(0)
+	if latency > 0 {
+		v = uint64(latency)
+	}
+	h.buckets[histBucket(v)].Add(1)
+	h.count.Add(1)
+	h.sum.Add(v)
+	for {
+		old := h.min.Load()
+		if v >= old || h.min.CompareAndSwap(old, v) {
+			break
+		}
+	}
+	for {
+		old := h.max.Load()
+		if v <= old || h.max.CompareAndSwap(old, v) {
+			break
+		}
+	}
+}
+
+// Merge adds all samples recorded in other to h
+func (h *LatencyHistogram) Merge(other *LatencyHistogram) {
+	if other == nil || other.count.Load() == 0 {
+		return
+	}
+	for i := range other.buckets {
+		if n := other.buckets[i].Load(); n > 0 {
+			h.buckets[i].Add(n)
+		}
+	}
+	h.count.Add(other.count.Load())
+	h.sum.Add(other.sum.Load())
+	for {
+		old := h.min.Load()
+		v := other.min.Load()
+		if v >= old || h.min.CompareAndSwap(old, v) {
+			break
+		}
+	}
+	for {
+		old := h.max.Load()
+		v := other.max.Load()
+		if v <= old || h.max.CompareAndSwap(old, v) {
+			break
+		}
+	}
+}
+
+// Count returns the number of recorded samples
+func (h *LatencyHistogram) Count() uint64 {
+	return h.count.Load()
+}
+
+// Mean returns the exact mean of the recorded samples
+func (h *LatencyHistogram) Mean() float64 {
+	count := h.count.Load()
+	if count == 0 {
+		return 0
+	}
+	return float64(h.sum.Load()) / float64(count)
+}
+
+// Min returns the exact smallest recorded sample
+func (h *LatencyHistogram) Min() float64 {
+	if h.count.Load() == 0 {
+		return 0
+	}
+	return float64(h.min.Load())
+}
+
+// Max returns the exact largest recorded sample
+func (h *LatencyHistogram) Max() float64 {
+	if h.count.Load() == 0 {
+		return 0
+	}
+	return float64(h.max.Load())
+}
+
+// histogramBucketJSON is one populated bucket in the wire form
+type histogramBucketJSON struct {
+	Index int    `json:"index"`
+	Count uint64 `json:"count"`
+}
+
+// histogramJSON is the wire form of a LatencyHistogram, listing only the
+// populated buckets so a mostly empty histogram stays small
+type histogramJSON struct {
+	Buckets []histogramBucketJSON `json:"buckets"`
+	Count   uint64                `json:"count"`
+	Sum     uint64                `json:"sum"`
+	Min     uint64                `json:"min"`
+	Max     uint64                `json:"max"`
+}
+
+// MarshalJSON serializes the histogram so agents can stream it to a controller
+func (h *LatencyHistogram) MarshalJSON() ([]byte, error) {
+	wire := histogramJSON{
+		Buckets: make([]histogramBucketJSON, 0),
+		Count:   h.count.Load(),
+		Sum:     h.sum.Load(),
+		Min:     h.min.Load(),
+		Max:     h.max.Load(),
+	}
+	for i := range h.buckets {
+		if n := h.buckets[i].Load(); n > 0 {
+			wire.Buckets = append(wire.Buckets, histogramBucketJSON{Index: i, Count: n})
+		}
+	}
+	return json.Marshal(wire)
+}
+
+// UnmarshalJSON restores a histogram serialized by MarshalJSON
+func (h *LatencyHistogram) UnmarshalJSON(data []byte) error {
+	var wire histogramJSON
+	if err := json.Unmarshal(data, &wire); err != nil {
+		return err
+	}
+	for i := range h.buckets {
+		h.buckets[i].Store(0)
+	}
+	for _, b := range wire.Buckets {
+		if b.Index < 0 || b.Index >= histBucketCount {
+			return fmt.Errorf("histogram bucket index %d out of range", b.Index)
+		}
+		h.buckets[b.Index].Store(b.Count)
+	}
+	h.count.Store(wire.Count)
+	h.sum.Store(wire.Sum)
+	h.min.Store(wire.Min)
+	h.max.Store(wire.Max)
+	return nil
+}
+
+// Quantile returns an upper estimate of the q quantile (0 <= q <= 1) of the
+// recorded samples, accurate to one bucket width (~3% relative error). It
+// returns 0 when the histogram is empty.
+func (h *LatencyHistogram) Quantile(q float64) float64 {
+	total := h.count.Load()
+	if total == 0 {
+		return 0
+	}
+	rank := uint64(math.Ceil(q * float64(total)))
+	if rank < 1 {
+		rank = 1
+	}
+	var cum uint64
+	for i := range h.buckets {
+		cum += h.buckets[i].Load()
+		if cum >= rank {
+			// the tracked extremes are exact, never report beyond them
+			upper := histBucketUpper(i)
+			if max := h.Max(); upper > max {
+				return max
+			}
+			if min := h.Min(); upper < min {
+				return min
+			}
+			return upper
+		}
+	}
+	return h.Max()
+}
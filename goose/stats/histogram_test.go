@@ -0,0 +1,104 @@
+/*
+Copyright (c) Facebook, Inc. and its affiliates.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+package stats
+
+import (
+	"encoding/json"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func Test_histBucketRoundTrip(t *testing.T) {
+	// The upper edge of a sample's bucket must cover the sample and stay
+	// within one sub-bucket width (1/32) of it.
+	for v := uint64(1); v < uint64(1)<<histMaxExp; v = v*3/2 + 1 {
+		upper := histBucketUpper(histBucket(v))
+		require.GreaterOrEqual(t, upper, float64(v))
+		require.LessOrEqual(t, upper, float64(v)*(1+1.0/histSubCount)+1)
+	}
+}
+
+func Test_histogramQuantiles(t *testing.T) {
+	h := NewLatencyHistogram()
+	for i := 1; i <= 1000; i++ {
+		h.Add(float64(i))
+	}
+	require.Equal(t, uint64(1000), h.Count())
+	require.Equal(t, float64(1), h.Min())
+	require.Equal(t, float64(1000), h.Max())
+	require.Equal(t, float64(500.5), h.Mean())
+	// quantiles are upper estimates, accurate to one sub-bucket (~3%)
+	p50 := h.Quantile(0.5)
+	require.GreaterOrEqual(t, p50, float64(500))
+	require.LessOrEqual(t, p50, float64(500)*1.04)
+	p99 := h.Quantile(0.99)
+	require.GreaterOrEqual(t, p99, float64(990))
+	require.LessOrEqual(t, p99, float64(990)*1.04)
+}
+
+func Test_histogramQuantileEmpty(t *testing.T) {
+	h := NewLatencyHistogram()
+	require.Zero(t, h.Quantile(0.5))
+	require.Zero(t, h.Min())
+	require.Zero(t, h.Max())
+	require.Zero(t, h.Mean())
+}
+
+func Test_histogramClampsHugeSamples(t *testing.T) {
+	h := NewLatencyHistogram()
+	h.Add(1e15) // beyond the last resolved bucket
+	require.Equal(t, float64(1e15), h.Max())
+	// the reported quantile is clamped to the tracked exact maximum
+	require.Equal(t, float64(1e15), h.Quantile(1))
+}
+
+func Test_histogramJSONRoundTrip(t *testing.T) {
+	h := NewLatencyHistogram()
+	for _, sample := range []float64{1, 1000, 123456, 1e15} {
+		h.Add(sample)
+	}
+	data, err := json.Marshal(h)
+	require.NoError(t, err)
+	restored := &LatencyHistogram{}
+	require.NoError(t, json.Unmarshal(data, restored))
+	require.Equal(t, h, restored)
+
+	// an empty histogram keeps its sentinel minimum across the wire
+	empty := NewLatencyHistogram()
+	data, err = json.Marshal(empty)
+	require.NoError(t, err)
+	restored = &LatencyHistogram{}
+	require.NoError(t, json.Unmarshal(data, restored))
+	require.Equal(t, empty, restored)
+
+	require.Error(t, json.Unmarshal([]byte(`{"buckets":[{"index":-1,"count":1}]}`), restored))
+}
+
+func Test_histogramMerge(t *testing.T) {
+	a := NewLatencyHistogram()
+	b := NewLatencyHistogram()
+	combined := NewLatencyHistogram()
+	for i := 1; i <= 100; i++ {
+		combined.Add(float64(i))
+		if i%2 == 0 {
+			a.Add(float64(i))
+		} else {
+			b.Add(float64(i))
+		}
+	}
+	a.Merge(b)
+	a.Merge(nil) // merging nil is a no-op
+	require.Equal(t, combined, a)
+}
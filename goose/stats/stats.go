@@ -14,10 +14,7 @@ limitations under the License.
 package stats
 
 import (
-	"sort"
 	"time"
-
-	"gonum.org/v1/gonum/stat"
 )
 
 // Reporter is used to report stats
@@ -26,14 +23,6 @@ type Reporter interface {
 	Initialize() error
 }
 
-func average(samples []float64) float64 {
-	total := float64(0)
-	for _, x := range samples {
-		total += x
-	}
-	return total / float64(len(samples))
-}
-
 // ExportedMetrics holds the basic metrics returned by the query engine
 type ExportedMetrics struct {
 	Elapsed time.Duration
@@ -41,8 +30,25 @@ type ExportedMetrics struct {
 	Processed int
 	// errors is the number of queries that failed.
 	Errors int
-	// Latencies contain per query latency
-	Latencies []float64
+	// Latencies holds the per query latency histogram
+	Latencies *LatencyHistogram
+}
+
+// MergeMetrics combines metrics collected by concurrent sources - worker
+// states of one engine, or remote agents of a coordinated test - into one
+// result. Counters and latencies add up; the sources run concurrently, so
+// the longest elapsed time is the merged elapsed time.
+func MergeMetrics(metrics []*ExportedMetrics) *ExportedMetrics {
+	merged := &ExportedMetrics{Latencies: NewLatencyHistogram()}
+	for _, m := range metrics {
+		if m.Elapsed > merged.Elapsed {
+			merged.Elapsed = m.Elapsed
+		}
+		merged.Processed += m.Processed
+		merged.Errors += m.Errors
+		merged.Latencies.Merge(m.Latencies)
+	}
+	return merged
 }
 
 // QPSTotal returns the number of queries processed in one second.
@@ -69,15 +75,14 @@ func newLatencyStats() *LatencyStats {
 // AggregateLatencies aggregates query latency metrics
 func (m *ExportedMetrics) AggregateLatencies() *LatencyStats {
 	l := newLatencyStats()
-	sort.Float64s(m.Latencies)
-	if len(m.Latencies) > 0 {
-		l.Min = stat.Quantile(0.0, stat.Empirical, m.Latencies, nil)
-		l.Max = stat.Quantile(1.0, stat.Empirical, m.Latencies, nil)
-		l.Mean = stat.Mean(m.Latencies, nil)
-		l.Median = stat.Quantile(0.5, stat.Empirical, m.Latencies, nil)
-		l.Upperq = stat.Quantile(0.75, stat.Empirical, m.Latencies, nil)
-		l.Lowerq = stat.Quantile(0.25, stat.Empirical, m.Latencies, nil)
-		l.Average = average(m.Latencies)
+	if m.Latencies != nil && m.Latencies.Count() > 0 {
+		l.Min = m.Latencies.Min()
+		l.Max = m.Latencies.Max()
+		l.Mean = m.Latencies.Mean()
+		l.Median = m.Latencies.Quantile(0.5)
+		l.Upperq = m.Latencies.Quantile(0.75)
+		l.Lowerq = m.Latencies.Quantile(0.25)
+		l.Average = l.Mean
 	}
 	return l
 }
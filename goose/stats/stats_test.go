@@ -21,13 +21,22 @@ import (
 )
 
 func Test_latencyAggregator(t *testing.T) {
-	e := &ExportedMetrics{Elapsed: 3 * time.Second, Processed: 8, Errors: 0, Latencies: []float64{25.01, 35.02, 10.03, 17.04, 29.05, 14.06, 21.07, 31.08}}
+	latencies := NewLatencyHistogram()
+	for _, sample := range []float64{25, 35, 10, 17, 29, 14, 21, 31} {
+		latencies.Add(sample)
+	}
+	e := &ExportedMetrics{Elapsed: 3 * time.Second, Processed: 8, Errors: 0, Latencies: latencies}
 	w := e.AggregateLatencies()
 
-	require.Equal(t, float64(10.03), w.Min)
-	require.Equal(t, float64(35.02), w.Max)
-	require.Equal(t, float64(22.795), w.Mean)
-	require.Equal(t, float64(21.07), w.Median)
-	require.Equal(t, float64(14.06), w.Lowerq)
-	require.Equal(t, float64(29.05), w.Upperq)
+	require.Equal(t, float64(10), w.Min)
+	require.Equal(t, float64(35), w.Max)
+	require.Equal(t, float64(22.75), w.Mean)
+	require.Equal(t, float64(21), w.Median)
+	require.Equal(t, float64(14), w.Lowerq)
+	require.Equal(t, float64(29), w.Upperq)
+}
+
+func Test_latencyAggregatorEmpty(t *testing.T) {
+	e := &ExportedMetrics{Elapsed: time.Second, Latencies: NewLatencyHistogram()}
+	require.Equal(t, newLatencyStats(), e.AggregateLatencies())
 }